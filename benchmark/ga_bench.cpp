@@ -5,6 +5,7 @@
 #include "cye/individual.hpp"
 #include "cye/init_heuristics.hpp"
 #include "cye/instance.hpp"
+#include "cye/repair.hpp"
 #include "meta/common.hpp"
 #include "meta/ga/local_search.hpp"
 #include "meta/ga/ssga.hpp"
@@ -48,3 +49,46 @@ static void BM_GA(benchmark::State &state) {
 }
 
 BENCHMARK(BM_GA)->Unit(benchmark::kMillisecond);
+
+// Copies a 10k population the way the crossover operators start a child. The base storage is shared, so with a
+// range of 0 the copy only duplicates the patches. A range of 1 also writes one gene of every copy, which forces the
+// base to be copied. The copied_base_bytes counter reports how much base storage was duplicated per iteration.
+static void BM_PopulationCopy(benchmark::State &state) {
+  auto gen = std::mt19937(0);
+
+  auto archive = serial::JSONArchive("dataset/json/E-n101-k8.json");
+  auto instance = std::make_shared<cye::Instance>(archive.root());
+  auto energy_repair = std::make_shared<cye::OptimalEnergyRepair>(instance);
+
+  auto population_size = 10000UZ;
+  auto population = std::vector<cye::EVRPIndividual>();
+  population.reserve(population_size);
+  for (auto i = 0UZ; i < population_size; ++i) {
+    population.emplace_back(energy_repair, cye::random_customer_permutation(gen, instance));
+  }
+
+  auto mutate = state.range(0) != 0;
+  auto copied_base_bytes = 0UZ;
+  for (auto _ : state) {
+    auto copies = population;
+    if (mutate) {
+      for (auto &individual : copies) {
+        individual.genotype()[0] = individual.genotype()[0];
+      }
+    }
+    benchmark::DoNotOptimize(copies);
+
+    state.PauseTiming();
+    copied_base_bytes = 0UZ;
+    for (auto i = 0UZ; i < population_size; ++i) {
+      if (!std::as_const(copies[i]).solution().routes().shares_base_with(population[i].solution().routes())) {
+        copied_base_bytes += std::as_const(copies[i]).genotype().size() * sizeof(size_t);
+      }
+    }
+    state.ResumeTiming();
+  }
+
+  state.counters["copied_base_bytes"] = static_cast<double>(copied_base_bytes);
+}
+
+BENCHMARK(BM_PopulationCopy)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
@@ -67,7 +67,7 @@ static void BM_GenGA_Optimization(benchmark::State &state) {
     // ga.add_local_search(std::make_unique<cye::SATwoOptSearch>(instance));
     //ga.add_local_search(std::make_unique<cye::TwoOptSearch>(instance));
     //ga.add_local_search(std::make_unique<cye::SwapSearch>(instance));
-    ga.add_local_search(std::make_unique<cye::SOTASearch>(instance));
+    ga.add_local_search(std::make_unique<cye::SOTASearch>(energy_repair, instance));
 
     ga.optimize(gen);
     auto best_individual = ga.best_individual();
@@ -75,12 +75,16 @@ static void BM_GenGA_Optimization(benchmark::State &state) {
 
     auto solution = best_individual.solution();
     solution.clear_patches();
-    cye::patch_cargo_optimally(solution, static_cast<unsigned>(instance->cargo_capacity()) + 1u);
-    energy_repair->patch(solution, 100001);
+    cye::patch_cargo_optimally(solution);
+    energy_repair->patch(solution);
 
     local_best_costs.push_back(std::min(best_cost, solution.cost()));
   }
 
+  auto const &route_cache = energy_repair->route_cache();
+  state.counters["route_cache_hit_rate"] = route_cache->hit_rate();
+  state.counters["route_cache_mb"] = static_cast<double>(route_cache->memory_usage()) / (1 << 20);
+
   {
     std::lock_guard<std::mutex> lock(stats_mutex);
     global_best_costs.insert(global_best_costs.end(), local_best_costs.begin(), local_best_costs.end());
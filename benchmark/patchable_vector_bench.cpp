@@ -2,22 +2,28 @@
 #include <cstddef>
 #include <cye/patchable_vector.hpp>
 #include <iostream>
+#include <memory>
 #include <random>
 #include <ranges>
+#include <span>
 #include <vector>
-
-static void BM_PatchableVectorIteration(benchmark::State &state) {
+#include "cye/init_heuristics.hpp"
+#include "cye/instance.hpp"
+#include "cye/repair.hpp"
+#include "cye/solution.hpp"
+#include "serial/json_archive.hpp"
+
+template <size_t MaxDepth = std::dynamic_extent>
+static auto make_patched_vector(size_t element_cnt, size_t patch_cnt, size_t change_cnt)
+    -> cye::PatchableVector<size_t, MaxDepth> {
   auto gen = std::mt19937(0);
 
   auto dist = std::uniform_int_distribution(1UZ, 100UZ);
-  auto element_cnt = 1000UZ;
-  auto patch_cnt = 5UZ;
-  auto change_cnt = 50UZ;
 
   auto elements = std::vector<size_t>();
   for (auto i = 0UZ; i < element_cnt; ++i) elements.push_back(dist(gen));
 
-  auto patchable_vec = cye::PatchableVector<size_t>(std::move(elements));
+  auto patchable_vec = cye::PatchableVector<size_t, MaxDepth>(std::move(elements));
 
   for (auto p = 0UZ; p < patch_cnt; ++p) {
     auto insertion_dist = std::uniform_int_distribution(0UZ, patchable_vec.size());
@@ -35,13 +41,46 @@ static void BM_PatchableVectorIteration(benchmark::State &state) {
     patchable_vec.add_patch(std::move(patch));
   }
 
+  return patchable_vec;
+}
+
+static void BM_PatchableVectorIteration(benchmark::State &state) {
+  auto patchable_vec = make_patched_vector(1000UZ, static_cast<size_t>(state.range(0)), 50UZ);
+  const auto &ref = patchable_vec;
+
   for (auto _ : state) {
-    for (auto it = patchable_vec.begin(); it != patchable_vec.end(); ++it) {
+    for (auto it = ref.begin(); it != ref.end(); ++it) {
       benchmark::DoNotOptimize(*it);
     }
   }
 }
 
+// Iteration over the cached view, the view is built once before the timed loop.
+static void BM_PatchableVectorViewIteration(benchmark::State &state) {
+  auto patchable_vec = make_patched_vector(1000UZ, static_cast<size_t>(state.range(0)), 50UZ);
+  const auto &ref = patchable_vec;
+  benchmark::DoNotOptimize(ref.view());
+
+  for (auto _ : state) {
+    for (auto value : ref.view()) {
+      benchmark::DoNotOptimize(value);
+    }
+  }
+}
+
+// Worst case for the view, every iteration invalidates it and it has to be rebuilt before walking it.
+static void BM_PatchableVectorViewRebuild(benchmark::State &state) {
+  auto patchable_vec = make_patched_vector(1000UZ, static_cast<size_t>(state.range(0)), 50UZ);
+  const auto &ref = patchable_vec;
+
+  for (auto _ : state) {
+    patchable_vec.add_patch(patchable_vec.pop_patch());
+    for (auto value : ref.view()) {
+      benchmark::DoNotOptimize(value);
+    }
+  }
+}
+
 static void BM_VectorIteration(benchmark::State &state) {
   auto gen = std::mt19937(0);
 
@@ -77,7 +116,53 @@ static void BM_VectorIteration(benchmark::State &state) {
   }
 }
 
-BENCHMARK(BM_PatchableVectorIteration);
+template <size_t MaxDepth>
+static void BM_IteratorCreation(benchmark::State &state) {
+  auto patchable_vec = make_patched_vector<MaxDepth>(1000UZ, 2UZ, 50UZ);
+  const auto &ref = patchable_vec;
+
+  for (auto _ : state) {
+    auto it = ref.begin();
+    benchmark::DoNotOptimize(*it);
+  }
+}
+
+// Cost of a cargo and energy patched route, iterating with heap allocated (dynamic depth) or inline level state.
+template <size_t MaxDepth>
+static void BM_RouteCostIteration(benchmark::State &state) {
+  auto archive = serial::JSONArchive("dataset/json/X-n916-k207.json");
+  auto instance = std::make_shared<cye::Instance>(archive.root());
+
+  auto solution = cye::nearest_neighbor(instance);
+  cye::patch_cargo_optimally(solution);
+  cye::patch_energy_trivially(solution);
+
+  auto routes = cye::PatchableVector<size_t, MaxDepth>(std::vector(solution.base()));
+  for (auto p = 0UZ; p < 2UZ; ++p) {
+    auto patch = solution.get_patch(p);
+    routes.add_patch(std::move(patch));
+  }
+  const auto &ref = routes;
+
+  for (auto _ : state) {
+    auto cost = 0.0;
+    auto it = ref.begin();
+    auto previous_node_id = *it;
+    for (++it; it != ref.end(); ++it) {
+      cost += instance->distance(previous_node_id, *it);
+      previous_node_id = *it;
+    }
+    benchmark::DoNotOptimize(cost);
+  }
+}
+
+BENCHMARK(BM_PatchableVectorIteration)->Arg(1)->Arg(2)->Arg(5);
+BENCHMARK(BM_PatchableVectorViewIteration)->Arg(1)->Arg(2)->Arg(5);
+BENCHMARK(BM_PatchableVectorViewRebuild)->Arg(1)->Arg(2)->Arg(5);
 BENCHMARK(BM_VectorIteration);
+BENCHMARK_TEMPLATE(BM_IteratorCreation, std::dynamic_extent);
+BENCHMARK_TEMPLATE(BM_IteratorCreation, cye::max_route_patch_depth);
+BENCHMARK_TEMPLATE(BM_RouteCostIteration, std::dynamic_extent)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_RouteCostIteration, cye::max_route_patch_depth)->Unit(benchmark::kMicrosecond);
 
 BENCHMARK_MAIN();
\ No newline at end of file
@@ -1,15 +1,27 @@
 #include <benchmark/benchmark.h>
+#include <sys/resource.h>
+#include <array>
+#include <random>
+#include <string>
+#include <vector>
 #include "cye/init_heuristics.hpp"
 #include "cye/instance.hpp"
 #include "cye/repair.hpp"
 #include "serial/json_archive.hpp"
 
+// Peak resident set size of the whole process so far.
+static auto peak_rss_mb() -> double {
+  auto usage = rusage();
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<double>(usage.ru_maxrss) / 1024.0;
+}
+
 static void BM_Repair_PatchCargoTrivially(benchmark::State &state) {
   auto archive = serial::JSONArchive("dataset/json/X-n916-k207.json");
   auto instance = std::make_shared<cye::Instance>(archive.root());
 
   auto solution = cye::nearest_neighbor(instance);
-  solution.pop_patch();
+  cye::patch_cargo_trivially(solution);
 
   for (auto _ : state) {
     solution.pop_patch();
@@ -23,20 +35,101 @@ static void BM_Repair_PatchCargoOptimally(benchmark::State &state) {
   auto instance = std::make_shared<cye::Instance>(archive.root());
 
   auto solution = cye::nearest_neighbor(instance);
+  cye::patch_cargo_trivially(solution);
+  auto workspace = cye::CargoDPWorkspace();
+
+  for (auto _ : state) {
+    solution.pop_patch();
+    cye::patch_cargo_optimally(solution, instance->cargo_bin_cnt(), workspace);
+    benchmark::DoNotOptimize(solution);
+  }
+
+  state.counters["workspace_mb"] = static_cast<double>(workspace.memory_usage()) / (1024.0 * 1024.0);
+  state.counters["peak_rss_mb"] = peak_rss_mb();
+}
+
+static void BM_Repair_PatchCargoOptimallyLabels(benchmark::State &state) {
+  auto archive = serial::JSONArchive("dataset/json/X-n916-k207.json");
+  auto instance = std::make_shared<cye::Instance>(archive.root());
+
+  auto solution = cye::nearest_neighbor(instance);
+  cye::patch_cargo_trivially(solution);
+  auto workspace = cye::CargoLabelWorkspace();
+
+  for (auto _ : state) {
+    solution.pop_patch();
+    cye::patch_cargo_optimally(solution, workspace);
+    benchmark::DoNotOptimize(solution);
+  }
+
+  state.counters["labels_per_node"] =
+      static_cast<double>(workspace.label_cnt()) / static_cast<double>(solution.visited_node_cnt());
+  state.counters["workspace_mb"] = static_cast<double>(workspace.memory_usage()) / (1024.0 * 1024.0);
+}
+
+static void BM_Repair_PatchCargoIncrementally(benchmark::State &state) {
+  auto archive = serial::JSONArchive("dataset/json/X-n916-k207.json");
+  auto instance = std::make_shared<cye::Instance>(archive.root());
+
+  auto solution = cye::nearest_neighbor(instance);
+  cye::patch_cargo_trivially(solution);
+  auto workspace = cye::CargoLabelWorkspace();
   solution.pop_patch();
+  cye::patch_cargo_optimally(solution, workspace);
 
+  // Swaps two neighbouring customers in the middle of the tour, as a local search move would
+  auto ind = solution.visited_node_cnt() / 2;
   for (auto _ : state) {
     solution.pop_patch();
-    cye::patch_cargo_optimally(solution);
+    std::swap(solution.base()[ind], solution.base()[ind + 1]);
+    cye::patch_cargo_optimally(solution, workspace, ind, ind + 1);
+    benchmark::DoNotOptimize(solution);
+  }
+}
+
+static void BM_Repair_LinearSplit(benchmark::State &state) {
+  auto archive = serial::JSONArchive("dataset/json/X-n916-k207.json");
+  auto instance = std::make_shared<cye::Instance>(archive.root());
+
+  auto gen = std::mt19937(42);
+  auto solution = cye::stochastic_rank_nearest_neighbor(gen, instance, 3);
+  cye::linear_split(solution);
+
+  for (auto _ : state) {
+    solution.pop_patch();
+    cye::linear_split(solution);
     benchmark::DoNotOptimize(solution);
   }
 }
 
+// Splits a population of 256 tours, on as many threads as the argument says.
+static void BM_Repair_LinearSplitBatch(benchmark::State &state) {
+  auto archive = serial::JSONArchive("dataset/json/X-n916-k207.json");
+  auto instance = std::make_shared<cye::Instance>(archive.root());
+
+  auto gen = std::mt19937(42);
+  auto solutions = std::vector<cye::Solution>();
+  for (auto i = 0UZ; i < 256UZ; ++i) {
+    solutions.push_back(cye::stochastic_rank_nearest_neighbor(gen, instance, 3));
+  }
+  auto workspaces = std::vector<cye::SplitWorkspace>(static_cast<size_t>(state.range(0)));
+
+  for (auto _ : state) {
+    for (auto &solution : solutions) {
+      solution.clear_patches();
+    }
+    cye::linear_split(solutions, workspaces);
+    benchmark::DoNotOptimize(solutions);
+  }
+}
+
 static void BM_Repair_PatchEnergyTrivially(benchmark::State &state) {
   auto archive = serial::JSONArchive("dataset/json/X-n916-k207.json");
   auto instance = std::make_shared<cye::Instance>(archive.root());
 
   auto solution = cye::nearest_neighbor(instance);
+  cye::patch_cargo_optimally(solution);
+  cye::patch_energy_trivially(solution);
 
   for (auto _ : state) {
     solution.pop_patch();
@@ -45,21 +138,108 @@ static void BM_Repair_PatchEnergyTrivially(benchmark::State &state) {
   }
 }
 
+// X instances of growing size, picked by the benchmark argument
+static constexpr auto x_instance_names = std::array{"X-n143-k7", "X-n459-k26", "X-n916-k207"};
+
 static void BM_Repair_PatchEnergyOptimally(benchmark::State &state) {
-  auto archive = serial::JSONArchive("dataset/json/X-n916-k207.json");
+  auto name = std::string(x_instance_names[static_cast<size_t>(state.range(0))]);
+  auto archive = serial::JSONArchive("dataset/json/" + name + ".json");
   auto instance = std::make_shared<cye::Instance>(archive.root());
+  state.SetLabel(name);
 
   auto solution = cye::nearest_neighbor(instance);
   auto energy_repair = cye::OptimalEnergyRepair(instance);
+  cye::patch_cargo_optimally(solution);
+  auto cell_cnt = static_cast<int64_t>(solution.visited_node_cnt() * 101);
+  energy_repair.patch(solution, 101u);
 
   for (auto _ : state) {
     solution.pop_patch();
     energy_repair.patch(solution, 101u);
     benchmark::DoNotOptimize(solution);
   }
+
+  // Table cells relaxed per second, comparable across instances
+  state.SetItemsProcessed(state.iterations() * cell_cnt);
+}
+
+static void BM_Repair_PatchEnergyOptimallyLabels(benchmark::State &state) {
+  auto archive = serial::JSONArchive("dataset/json/X-n916-k207.json");
+  auto instance = std::make_shared<cye::Instance>(archive.root());
+
+  auto solution = cye::nearest_neighbor(instance);
+  auto energy_repair = cye::OptimalEnergyRepair(instance);
+  cye::patch_cargo_optimally(solution);
+  energy_repair.patch(solution);
+
+  for (auto _ : state) {
+    solution.pop_patch();
+    energy_repair.patch(solution);
+    benchmark::DoNotOptimize(solution);
+  }
+}
+
+// A GA child differs from its parent in a few routes, swapping two neighbouring customers models that
+static void BM_Repair_PatchEnergyRoutes(benchmark::State &state) {
+  auto archive = serial::JSONArchive("dataset/json/X-n916-k207.json");
+  auto instance = std::make_shared<cye::Instance>(archive.root());
+  std::mt19937 gen(0);
+
+  auto solution = cye::nearest_neighbor(instance);
+  auto energy_repair = cye::OptimalEnergyRepair(instance);
+  auto swap_ind = std::uniform_int_distribution<size_t>(0, instance->customer_cnt() - 2);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    solution.clear_patches();
+    auto ind = swap_ind(gen);
+    std::swap(solution.base()[ind], solution.base()[ind + 1]);
+    cye::patch_cargo_optimally(solution);
+    state.ResumeTiming();
+
+    if (state.range(0) == 0) {
+      energy_repair.patch(solution);
+    } else {
+      energy_repair.patch_routes(solution);
+    }
+    benchmark::DoNotOptimize(solution);
+  }
+
+  state.counters["route_cache_hit_rate"] = energy_repair.route_cache()->hit_rate();
+  state.counters["route_cache_mb"] = static_cast<double>(energy_repair.route_cache()->memory_usage()) / (1 << 20);
+}
+
+// Every route solved from scratch, without the route cache
+static void BM_Repair_PatchEnergyRoutesUncached(benchmark::State &state) {
+  auto name = std::string(x_instance_names[static_cast<size_t>(state.range(0))]);
+  auto archive = serial::JSONArchive("dataset/json/" + name + ".json");
+  auto instance = std::make_shared<cye::Instance>(archive.root());
+  state.SetLabel(name);
+
+  auto solution = cye::nearest_neighbor(instance);
+  auto energy_repair = cye::OptimalEnergyRepair(instance);
+  cye::patch_cargo_optimally(solution);
+  energy_repair.patch_routes(solution);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    solution.pop_patch();
+    energy_repair.route_cache()->clear();
+    state.ResumeTiming();
+
+    energy_repair.patch_routes(solution);
+    benchmark::DoNotOptimize(solution);
+  }
 }
 
 BENCHMARK(BM_Repair_PatchCargoTrivially)->Unit(benchmark::kMicrosecond);
 BENCHMARK(BM_Repair_PatchCargoOptimally)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Repair_PatchCargoOptimallyLabels)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Repair_PatchCargoIncrementally)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Repair_LinearSplit)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Repair_LinearSplitBatch)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_Repair_PatchEnergyTrivially)->Unit(benchmark::kMicrosecond);
-BENCHMARK(BM_Repair_PatchEnergyOptimally)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Repair_PatchEnergyOptimally)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Repair_PatchEnergyOptimallyLabels)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Repair_PatchEnergyRoutes)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Repair_PatchEnergyRoutesUncached)->DenseRange(0, 2)->Unit(benchmark::kMicrosecond);
@@ -44,8 +44,8 @@ static void BM_GA_Optimization(benchmark::State &state) {
     auto selection_operator = std::make_unique<meta::ga::KWayTournamentSelectionOperator<cye::EVRPIndividual>>(3);
 
     meta::ga::SSGA<cye::EVRPIndividual> ga(std::move(population), std::move(selection_operator),
-                                           std::make_unique<cye::SwapSearch>(instance), cye::EVRPStallHandler(),
-                                           1'000'000'000UZ, true);
+                                           std::make_unique<cye::SwapSearch>(energy_repair, instance),
+                                           cye::EVRPStallHandler(), 1'000'000'000UZ, true);
 
     // ga.add_crossover_operator(std::make_unique<meta::ga::OX1<cye::EVRPIndividual>>());
     //  ga.add_crossover_operator(std::make_unique<RouteOX1>());
@@ -60,12 +60,16 @@ static void BM_GA_Optimization(benchmark::State &state) {
 
     auto solution = best_individual.solution();
     solution.clear_patches();
-    cye::patch_cargo_optimally(solution, static_cast<unsigned>(instance->cargo_capacity()) + 1u);
-    energy_repair->patch(solution, 100001);
+    cye::patch_cargo_optimally(solution);
+    energy_repair->patch(solution);
 
     local_best_costs.push_back(std::min(best_cost, solution.cost()));
   }
 
+  auto const &route_cache = energy_repair->route_cache();
+  state.counters["route_cache_hit_rate"] = route_cache->hit_rate();
+  state.counters["route_cache_mb"] = static_cast<double>(route_cache->memory_usage()) / (1 << 20);
+
   {
     std::lock_guard<std::mutex> lock(stats_mutex);
     global_best_costs.insert(global_best_costs.end(), local_best_costs.begin(), local_best_costs.end());
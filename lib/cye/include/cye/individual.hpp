@@ -1,6 +1,10 @@
 #pragma once
 
 #include <cassert>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <vector>
 #include "cye/repair.hpp"
 #include "cye/solution.hpp"
 
@@ -8,7 +12,10 @@ namespace cye {
 
 class EVRPIndividual {
  public:
-  EVRPIndividual(std::shared_ptr<cye::OptimalEnergyRepair> energy_repair, cye::Solution &&solution);
+  // Unless max_route_cnt is empty, the cargo split uses at most that many routes whenever the tour can be served with
+  // them. Copies keep the limit, so it holds for the whole population.
+  EVRPIndividual(std::shared_ptr<cye::OptimalEnergyRepair> energy_repair, cye::Solution &&solution,
+                 std::optional<size_t> max_route_cnt = std::nullopt);
 
   [[nodiscard]] inline auto cost() const {
     assert(valid_);
@@ -42,12 +49,17 @@ class EVRPIndividual {
     valid_ = false;
   }
   auto update_cost() -> void;
+  // Clears the patches and splits the routes by cargo. The label fronts of the last split of the calling thread are
+  // kept, so if it split a tour of the same length, like the parent of a mutated child, only the part of the tour that
+  // changed since is relaxed again.
+  auto split_cargo() -> void;
 
  private:
   static constexpr size_t fnv_prime_ = 1099511628211u;
 
   std::shared_ptr<cye::OptimalEnergyRepair> energy_repair_;
   cye::Solution solution_;
+  std::optional<size_t> max_route_cnt_;
   bool trivial_{false};
   double cost_;
   size_t hash_;
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <ranges>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -23,7 +24,15 @@ class Instance {
   [[nodiscard]] inline auto customer_ids() const { return std::views::iota(1UZ, customer_cnt_ + 1); }
   [[nodiscard]] inline auto charging_station_ids() const { return std::views::iota(customer_cnt_ + 1, nodes_.size()); }
   [[nodiscard]] constexpr inline auto depot_id() const -> size_t { return 0UZ; }
+  [[nodiscard]] inline auto minimum_route_cnt() const { return minimum_route_cnt_; }
   [[nodiscard]] inline auto cargo_capacity() const { return cargo_capacity_; }
+  // Largest amount of cargo every demand and the capacity are a multiple of, remaining loads never fall between two
+  // multiples of it. Falls back to one unit if some value is not a whole number.
+  [[nodiscard]] inline auto cargo_quantum() const { return cargo_quantum_; }
+  // Number of remaining load states the cargo DP needs to be exact.
+  [[nodiscard]] inline auto cargo_bin_cnt() const {
+    return static_cast<unsigned>(cargo_capacity_ / cargo_quantum_) + 1u;
+  }
   [[nodiscard]] inline auto battery_capacity() const { return battery_capacity_; }
   [[nodiscard]] inline auto distance(size_t node1_id, size_t node2_id) const -> double {
     if (node1_id == node2_id) [[unlikely]] {
@@ -45,14 +54,23 @@ class Instance {
   [[nodiscard]] inline auto is_customer(size_t ind) const { return ind > 0 && ind <= customer_cnt_; }
   [[nodiscard]] inline auto is_charging_station(size_t ind) const { return ind == 0 || ind > customer_cnt_; }
   [[nodiscard]] inline auto &name() { return name_; }
+  // Charging stations and the depot a full battery gets to from the node, nearest first and ties by id. The node
+  // itself is left out.
+  [[nodiscard]] inline auto reachable_station_ids(size_t node_id) const {
+    return std::span<const size_t>(reachable_station_ids_.data() + reachable_station_offsets_[node_id],
+                                   reachable_station_offsets_[node_id + 1] - reachable_station_offsets_[node_id]);
+  }
 
  private:
   auto update_distance_cache_() -> void;
+  auto update_cargo_quantum_() -> void;
+  auto update_reachable_stations_() -> void;
 
   std::string name_;
   double optimal_value_;
   size_t minimum_route_cnt_;
   double cargo_capacity_;
+  double cargo_quantum_;
   double battery_capacity_;
   double energy_consumption_;
   size_t customer_cnt_;
@@ -60,6 +78,9 @@ class Instance {
 
   std::vector<Node> nodes_;
   std::vector<double> distance_cache_;
+  // Reachable stations of every node, one after another
+  std::vector<size_t> reachable_station_ids_;
+  std::vector<size_t> reachable_station_offsets_;
 };
 
 template <serial::Value V>
@@ -76,6 +97,8 @@ Instance::Instance(V &&value)
   std::ranges::stable_sort(
       nodes_, [](auto &n1, auto &n2) { return static_cast<uint8_t>(n1.type) < static_cast<uint8_t>(n2.type); });
   update_distance_cache_();
+  update_cargo_quantum_();
+  update_reachable_stations_();
 }
 
 template <serial::Value V>
@@ -36,6 +36,8 @@ class TwoOptSearch : public meta::ga::LocalSearch<cye::EVRPIndividual> {
  public:
   TwoOptSearch(std::shared_ptr<cye::Instance> instance)
       : energy_repair_(std::make_shared<cye::OptimalEnergyRepair>(instance)), instance_(instance) {}
+  TwoOptSearch(std::shared_ptr<cye::OptimalEnergyRepair> energy_repair, std::shared_ptr<cye::Instance> instance)
+      : energy_repair_(std::move(energy_repair)), instance_(instance) {}
 
   [[nodiscard]] auto search(meta::RandomEngine & /*gen*/, cye::EVRPIndividual &&individual)
       -> cye::EVRPIndividual override;
@@ -49,6 +51,8 @@ class SwapSearch : public meta::ga::LocalSearch<cye::EVRPIndividual> {
  public:
   SwapSearch(std::shared_ptr<cye::Instance> instance)
       : energy_repair_(std::make_shared<cye::OptimalEnergyRepair>(instance)), instance_(instance) {}
+  SwapSearch(std::shared_ptr<cye::OptimalEnergyRepair> energy_repair, std::shared_ptr<cye::Instance> instance)
+      : energy_repair_(std::move(energy_repair)), instance_(instance) {}
 
   [[nodiscard]] auto search(meta::RandomEngine & /*gen*/, cye::EVRPIndividual &&individual)
       -> cye::EVRPIndividual override;
@@ -77,6 +81,8 @@ class SOTASearch : public meta::ga::LocalSearch<cye::EVRPIndividual> {
   public:
    SOTASearch(std::shared_ptr<cye::Instance> instance)
        : energy_repair_(std::make_shared<cye::OptimalEnergyRepair>(instance)), instance_(instance) {}
+   SOTASearch(std::shared_ptr<cye::OptimalEnergyRepair> energy_repair, std::shared_ptr<cye::Instance> instance)
+       : energy_repair_(std::move(energy_repair)), instance_(instance) {}
  
    [[nodiscard]] auto search(meta::RandomEngine &gen, cye::EVRPIndividual &&individual) -> cye::EVRPIndividual override;
  
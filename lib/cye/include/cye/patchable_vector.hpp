@@ -1,17 +1,23 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cstddef>
 #include <initializer_list>
 #include <iterator>
+#include <memory>
 #include <span>
+#include <stdexcept>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace cye {
 
-template <typename T>
+// Passing a MaxDepth bounds the number of stacked patches, which lets the iterators keep their per-level state inline
+// instead of on the heap. The default, std::dynamic_extent, allows any depth.
+template <typename T, size_t MaxDepth = std::dynamic_extent>
 class PatchableVector;
 
 template <typename T>
@@ -26,6 +32,10 @@ class Patch {
 
   inline auto add_change(size_t ind, T const &value) { changes_.emplace_back(ind, value); }
 
+  // Hides the base element ind. Removals are only allowed in the first patch. The insertion indices of that patch and
+  // of every patch above it count the base without the removed elements.
+  inline auto add_removal(size_t ind) { removals_.push_back(ind); }
+
   inline auto reverse() { std::ranges::reverse(changes_); }
 
   inline auto sort() { std::ranges::stable_sort(changes_); }
@@ -35,51 +45,181 @@ class Patch {
   [[nodiscard]] inline auto back() const { return changes_.back(); }
   [[nodiscard]] inline auto empty() const { return changes_.empty(); }
   [[nodiscard]] inline auto &changes() const { return changes_; }
+  [[nodiscard]] inline auto &removals() const { return removals_; }
 
-  friend PatchableVector<T>;
+  template <typename, size_t>
+  friend class PatchableVector;
 
  private:
   std::vector<Change> changes_;
+  std::vector<size_t> removals_;
 };
 
-template <typename T>
+template <typename T, size_t MaxDepth>
 class PatchableVector {
  public:
   PatchableVector() = default;
-  PatchableVector(std::initializer_list<T> init) : base_(init) {}
-  PatchableVector(std::vector<T> &&base) : base_(std::move(base)) {}
+  PatchableVector(std::initializer_list<T> init) : base_(std::make_shared<std::vector<T>>(init)) {}
+  PatchableVector(std::vector<T> &&base) : base_(std::make_shared<std::vector<T>>(std::move(base))) {}
 
+  // With a bounded MaxDepth, a patch that would go past it is merged into the top patch, the two then pop as one and
+  // the patches below stay.
   inline auto add_patch(Patch<T> &&patch) {
 #ifndef NDEBUG
-    auto s = size();
-    for (auto i = 1UZ; i < patch.changes_.size(); ++i) {
-      assert(patch.changes_[i - 1].ind <= patch.changes_[i].ind);
+    assert(patch.removals_.empty() || patches_.empty());
+    for (auto i = 0UZ; i < patch.removals_.size(); ++i) {
+      assert(i == 0 || patch.removals_[i - 1] < patch.removals_[i]);
+      assert(patch.removals_[i] < base_->size());
+    }
+    auto s = size() - patch.removals_.size();
+    for (auto i = 0UZ; i < patch.changes_.size(); ++i) {
+      assert(i == 0 || patch.changes_[i - 1].ind <= patch.changes_[i].ind);
       assert(patch.changes_[i].ind <= s);
     }
 #endif
 
     patches_.push_back(std::move(patch));
+    if (patches_.size() > MaxDepth) {
+      merge_patch(patches_.size() - 2UZ);
+    }
+    invalidate_view_();
   }
 
-  inline auto clear_patches() { patches_.clear(); }
+  inline auto clear_patches() {
+    patches_.clear();
+    invalidate_view_();
+  }
   inline auto pop_patch() {
     auto tmp = std::move(patches_.back());
     patches_.pop_back();
+    invalidate_view_();
     return tmp;
   }
   [[nodiscard]] inline auto &get_patch(size_t ind) const { return patches_[ind]; }
+  [[nodiscard]] inline auto patch_cnt() const { return patches_.size(); }
+
+  // Composes the patch ind + 1 into the patch ind, the base and the patched sequence stay untouched. A change of the
+  // upper patch inserted at the position p of the level below lands in front of every lower change that ends up at p
+  // or later, so one merge pass over both change lists rewrites its index in O(total changes).
+  auto merge_patch(size_t ind) -> void {
+    assert(ind + 1UZ < patches_.size());
+
+    auto &lower = patches_[ind].changes_;
+    auto &upper = patches_[ind + 1UZ].changes_;
+    assert(patches_[ind + 1UZ].removals_.empty());
+
+    auto merged = std::vector<typename Patch<T>::Change>();
+    merged.reserve(lower.size() + upper.size());
+
+    auto m = 0UZ;
+    for (auto &change : upper) {
+      while (m < lower.size() && lower[m].ind + m < change.ind) {
+        merged.push_back(std::move(lower[m]));
+        ++m;
+      }
+      merged.emplace_back(change.ind - m, std::move(change.value));
+    }
+    for (; m < lower.size(); ++m) {
+      merged.push_back(std::move(lower[m]));
+    }
+
+    lower = std::move(merged);
+    patches_.erase(patches_.begin() + static_cast<std::ptrdiff_t>(ind + 1UZ));
+  }
+
+  // Collapses the whole patch stack into a single patch over the base.
+  auto merge_patches() -> void {
+    while (patches_.size() > 1UZ) {
+      merge_patch(patches_.size() - 2UZ);
+    }
+  }
+
+  // Handing out a mutable base may change the sequence, so the view has to be rebuilt afterwards.
+  inline auto &base() {
+    invalidate_view_();
+    return detach_base_();
+  }
+  inline auto &base() const { return std::as_const(*base_); }
+
+  // Copies share the base until one of them asks for mutable access to it.
+  [[nodiscard]] inline auto shares_base_with(PatchableVector const &other) const { return base_ == other.base_; }
 
-  inline auto &base() { return base_; }
-  inline auto &base() const { return base_; }
   [[nodiscard]] auto size() const {
-    auto size = base_.size();
+    auto size = base_->size();
     for (const auto &patch : patches_) {
-      size += patch.size();
+      size += patch.size() - patch.removals_.size();
     }
 
     return size;
   }
 
+  // Random access into the patched sequence. The m-th change of a patch lands at position ind + m of the level above
+  // it, so every level is resolved with one binary search over its changes and a lookup costs O(sum log(changes)).
+  [[nodiscard]] auto operator[](size_t ind) const -> T const & {
+    for (auto p = patches_.size(); p-- > 0;) {
+      auto &changes = patches_[p].changes_;
+      auto m = changes_before_(changes, ind);
+      if (m < changes.size() && changes[m].ind + m == ind) {
+        return changes[m].value;
+      }
+      ind -= m;
+    }
+
+    return (*base_)[raw_index_(ind)];
+  }
+  // The mutable overloads hand out writable elements and detach a shared base, read through std::as_const instead.
+  [[nodiscard]] auto operator[](size_t ind) -> T & {
+    invalidate_view_();
+    detach_base_();
+    return const_cast<T &>(std::as_const(*this)[ind]);
+  }
+
+  [[nodiscard]] auto at(size_t ind) const -> T const & {
+    if (ind >= size()) {
+      throw std::out_of_range("PatchableVector index out of range.");
+    }
+    return (*this)[ind];
+  }
+  [[nodiscard]] auto at(size_t ind) -> T & {
+    if (ind >= size()) {
+      throw std::out_of_range("PatchableVector index out of range.");
+    }
+    return (*this)[ind];
+  }
+
+  // Index of the first kept base element that is at or after the position ind of the patched sequence. Returns the base
+  // size if only inserted elements follow.
+  [[nodiscard]] auto base_lower_bound(size_t ind) const -> size_t {
+    for (auto p = patches_.size(); p-- > 0;) {
+      ind -= changes_before_(patches_[p].changes_, ind);
+    }
+
+    return raw_index_(ind);
+  }
+
+  // Position of the kept base element base_ind in the patched sequence.
+  [[nodiscard]] auto patched_index(size_t base_ind) const -> size_t {
+    if (!patches_.empty()) {
+      auto &removals = patches_.front().removals_;
+      base_ind -= static_cast<size_t>(std::ranges::lower_bound(removals, base_ind) - removals.begin());
+    }
+    for (const auto &patch : patches_) {
+      base_ind += static_cast<size_t>(std::ranges::upper_bound(patch.changes_, base_ind, std::less{},
+                                                               [](auto const &change) { return change.ind; }) -
+                                      patch.changes_.begin());
+    }
+
+    return base_ind;
+  }
+
+  // Calls f with the patched sequence split into contiguous std::span<const T> pieces, in order. Runs of base elements
+  // come out as one span each and every inserted value as a single element span, so consumers can run tight loops over
+  // the runs instead of stepping an iterator element by element.
+  template <typename F>
+  auto for_each_segment(F &&f) const -> void {
+    for_each_segment_(patches_.size(), 0UZ, size(), f);
+  }
+
   class Sentinel {};
 
   template <typename V>
@@ -104,10 +244,12 @@ class PatchableVector {
       bool started;  // Did we start iteration on that level? This is needed when the patch inserts at position 0.
     };
 
+    using PatchInfoStorage = std::conditional_t<MaxDepth == std::dynamic_extent, std::vector<PatchInfo>,
+                                                std::array<PatchInfo, MaxDepth>>;
+
     Iterator();
 
-    Iterator(size_t base_ind, bool started_base, std::vector<PatchInfo> &&patch_info, BaseVecPtr base,
-             PatchVecPtr patches);
+    Iterator(size_t base_ind, bool started_base, PatchInfoStorage &&patch_info, BaseVecPtr base, PatchVecPtr patches);
 
     auto operator*() const -> reference { return *current_value_; }
     auto operator->() const -> pointer { return current_value_; }
@@ -127,21 +269,47 @@ class PatchableVector {
     friend auto operator==(const Iterator &a, Sentinel) { return a.current_value_ == nullptr; }
     friend auto operator==(Sentinel, const Iterator &a) { return a.current_value_ == nullptr; }
 
+    // Level state for depth patches, only an unbounded MaxDepth puts it on the heap.
+    static auto make_patch_info(size_t depth) -> PatchInfoStorage {
+      if constexpr (MaxDepth == std::dynamic_extent) {
+        return PatchInfoStorage(depth, PatchInfo{0, 0, false});
+      } else {
+        auto patch_info = PatchInfoStorage();
+        patch_info.fill(PatchInfo{0, 0, false});
+        return patch_info;
+      }
+    }
+
    private:
     inline auto patch_size_(size_t i) const { return (*patches_)[i].changes_.size(); }
     inline auto reached_end_of_patch_(size_t i) const { return patch_info_[i].change_index >= patch_size_(i); }
     inline auto &change_(size_t i) const { return (*patches_)[i].changes_[patch_info_[i].change_index]; }
     inline auto &prev_change_(size_t i) const { return (*patches_)[i].changes_[patch_info_[i].change_index - 1UZ]; }
-    inline auto predecessor_ind_(size_t i) { return i == 0 ? base_ind_ : patch_info_[i - 1UZ].index; }
+    inline auto predecessor_ind_(size_t i) {
+      return i == 0 ? base_ind_ - removal_index_ : patch_info_[i - 1UZ].index;
+    }
     inline auto predecessor_started_(size_t i) -> bool { return i == 0 ? started_base_ : patch_info_[i - 1UZ].started; }
     auto find_prev_value_() -> pointer;
 
+    inline auto has_removal_(size_t removal_ind) const {
+      return removals_ != nullptr && removal_ind < removals_->size();
+    }
+    auto skip_removed_() -> void;
+    auto step_base_back_() -> bool;
+
     V *current_value_;
 
     size_t base_ind_;
     bool started_base_;
 
-    std::vector<PatchInfo> patch_info_;
+    // Removals of the first patch and how many of them lie in front of base_ind_.
+    std::vector<size_t> const *removals_;
+    size_t removal_index_;
+
+    // Cached patch count. With a bounded MaxDepth the per-level loops get a compile-time trip count bound, which lets
+    // the compiler unroll them.
+    size_t depth_;
+    PatchInfoStorage patch_info_;
 
     BaseVecPtr base_;
     PatchVecPtr patches_;
@@ -153,86 +321,284 @@ class PatchableVector {
   static_assert(std::sentinel_for<Sentinel, Iterator<const T>>);
 
   [[nodiscard]] auto begin() -> Iterator<T> {
-    return Iterator<T>(
-        0UZ, false,
-        std::vector<typename Iterator<T>::PatchInfo>(patches_.size(), typename Iterator<T>::PatchInfo{0, 0, false}),
-        &base_, &patches_);
+    invalidate_view_();
+    return Iterator<T>(0UZ, false, Iterator<T>::make_patch_info(patches_.size()), &detach_base_(), &patches_);
   }
 
   [[nodiscard]] auto begin() const -> Iterator<const T> {
-    return Iterator<const T>(0UZ, false,
-                             std::vector<typename Iterator<const T>::PatchInfo>(
-                                 patches_.size(), typename Iterator<const T>::PatchInfo{0, 0, false}),
-                             &base_, &patches_);
+    return Iterator<const T>(0UZ, false, Iterator<const T>::make_patch_info(patches_.size()), base_.get(), &patches_);
   }
 
   [[nodiscard]] auto end() -> Sentinel { return {}; }
   [[nodiscard]] auto end() const -> Sentinel { return {}; }
 
   [[nodiscard]] auto rbegin() -> Iterator<T> {
-    auto patch_info = std::vector<typename Iterator<const T>::PatchInfo>(patches_.size());
+    invalidate_view_();
+    return rbegin_<T>(&detach_base_(), &patches_);
+  }
+  [[nodiscard]] auto rbegin() const -> Iterator<const T> { return rbegin_<const T>(base_.get(), &patches_); }
 
-    for (auto i = 0UZ; i < patches_.size(); ++i) {
-      patch_info[i].index = i == 0 ? base_.size() : patch_info[i - 1].index;
-      patch_info[i].index += patches_[i].changes_.size();
-      patch_info[i].change_index = patches_[i].changes_.size();
-      patch_info[i].started = true;
+  // The new base is written to fresh storage, so the elements are only moved out when nobody else shares the base.
+  auto squash() {
+    auto new_base = std::make_shared<std::vector<T>>();
+    new_base->reserve(size());
+
+    if (base_.use_count() == 1) {
+      for (auto it = begin(); it != end(); ++it) {
+        new_base->push_back(std::move(*it));
+      }
+    } else {
+      for (auto it = std::as_const(*this).begin(); it != end(); ++it) {
+        new_base->push_back(*it);
+      }
     }
 
-    return --Iterator<const T>(base_.size(), true, std::move(patch_info), &base_, &patches_);
+    base_ = std::move(new_base);
+    patches_.clear();
+    invalidate_view_();
   }
-  [[nodiscard]] auto rbegin() const -> Iterator<const T> {
-    auto patch_info = std::vector<typename Iterator<const T>::PatchInfo>(patches_.size());
 
-    for (auto i = 0UZ; i < patches_.size(); ++i) {
-      patch_info[i].index = i == 0 ? base_.size() : patch_info[i - 1].index;
-      patch_info[i].index += patches_[i].changes_.size();
-      patch_info[i].change_index = patches_[i].changes_.size();
+  // Read-only branch of a frozen PatchableVector with its own top patch. The base and the patches below are shared with
+  // the snapshot and with every other fork of it, so evaluating a candidate move copies nothing but its own changes.
+  // Forks only read the snapshot, several of them can be used from different threads at once.
+  class Fork {
+   public:
+    Fork(std::shared_ptr<const PatchableVector> snapshot, Patch<T> &&top)
+        : snapshot_(std::move(snapshot)), top_(std::move(top)) {
+      assert(top_.removals_.empty());
+#ifndef NDEBUG
+      auto s = snapshot_->size();
+      for (auto i = 0UZ; i < top_.changes_.size(); ++i) {
+        assert(i == 0 || top_.changes_[i - 1].ind <= top_.changes_[i].ind);
+        assert(top_.changes_[i].ind <= s);
+      }
+#endif
+    }
+
+    [[nodiscard]] inline auto &snapshot() const { return *snapshot_; }
+    [[nodiscard]] inline auto &top_patch() const { return top_; }
+    [[nodiscard]] inline auto size() const { return snapshot_->size() + top_.size(); }
+
+    [[nodiscard]] auto operator[](size_t ind) const -> T const & {
+      auto m = changes_before_(top_.changes_, ind);
+      if (m < top_.changes_.size() && top_.changes_[m].ind + m == ind) {
+        return top_.changes_[m].value;
+      }
+      return (*snapshot_)[ind - m];
+    }
+
+    template <typename F>
+    auto for_each_segment(F &&f) const -> void {
+      split_segments_(top_.changes_, 0UZ, size(), f, [&](size_t lower_begin, size_t lower_end) {
+        snapshot_->for_each_segment_(snapshot_->patches_.size(), lower_begin, lower_end, f);
+      });
+    }
+
+    // The snapshot with the top patch applied. It shares the base with the snapshot until it is modified, so the caller
+    // can swap it in place of the vector it forked from in one move.
+    [[nodiscard]] auto commit() && -> PatchableVector {
+      auto committed = *snapshot_;
+      committed.add_patch(std::move(top_));
+      return committed;
+    }
+
+   private:
+    std::shared_ptr<const PatchableVector> snapshot_;
+    Patch<T> top_;
+  };
+
+  // Frozen copy to fork candidate branches from. It shares the base, only the patches are copied once.
+  [[nodiscard]] auto snapshot() const -> std::shared_ptr<const PatchableVector> {
+    return std::make_shared<const PatchableVector>(*this);
+  }
+
+  // Contiguous copy of the patched sequence. It is built on the first call and reused until the vector is modified, so
+  // repeated walks over the same patched sequence only pay for the patch traversal once. Building it writes to the
+  // vector even though the call is const, so it must not be called while other threads read the vector. Readers that
+  // may share a vector walk it with for_each_segment or the const iterators, which do not write.
+  [[nodiscard]] auto view() const -> std::span<const T> {
+    if (!view_valid_) {
+      // A copy may still read the old view, give it up instead of overwriting it.
+      if (view_.use_count() != 1) {
+        view_ = std::make_shared<std::vector<T>>();
+      }
+      view_->clear();
+      view_->reserve(size());
+      for (auto it = begin(); it != end(); ++it) {
+        view_->push_back(*it);
+      }
+      view_valid_ = true;
+    }
+
+    return *view_;
+  }
+
+ private:
+  inline auto invalidate_view_() { view_valid_ = false; }
+
+  // Gives this vector its own copy of the base if the storage is shared with a copy.
+  inline auto detach_base_() -> std::vector<T> & {
+    if (base_.use_count() != 1) {
+      base_ = std::make_shared<std::vector<T>>(std::as_const(*base_));
+    }
+    return *base_;
+  }
+
+  template <typename V>
+  static auto rbegin_(typename Iterator<V>::BaseVecPtr base, typename Iterator<V>::PatchVecPtr patches) -> Iterator<V> {
+    auto patch_info = Iterator<V>::make_patch_info(patches->size());
+
+    for (auto i = 0UZ; i < patches->size(); ++i) {
+      patch_info[i].index = i == 0 ? base->size() - (*patches)[0].removals_.size() : patch_info[i - 1].index;
+      patch_info[i].index += (*patches)[i].changes_.size();
+      patch_info[i].change_index = (*patches)[i].changes_.size();
       patch_info[i].started = true;
     }
 
-    return --Iterator<const T>(base_.size(), true, std::move(patch_info), &base_, &patches_);
+    return --Iterator<V>(base->size(), true, std::move(patch_info), base, patches);
   }
 
-  auto squash() {
-    auto new_base = std::vector<T>();
-    new_base.reserve(base_.size());
+  // Emits the range [begin, end) of the sequence produced by the first level patches.
+  template <typename F>
+  auto for_each_segment_(size_t level, size_t begin, size_t end, F &f) const -> void {
+    if (begin >= end) return;
+    if (level == 0) {
+      base_segments_(begin, end, f);
+      return;
+    }
+
+    split_segments_(patches_[level - 1UZ].changes_, begin, end, f, [&](size_t lower_begin, size_t lower_end) {
+      for_each_segment_(level - 1UZ, lower_begin, lower_end, f);
+    });
+  }
 
-    auto end_it = end();
-    for (auto it = begin(); it != end_it; ++it) {
-      new_base.push_back(std::move(*it));
+  // Emits the range [begin, end) of the level a patch with the given changes produces. Inserted values go to f and the
+  // runs in between are forwarded as ranges of the level below to lower.
+  template <typename F, typename L>
+  static auto split_segments_(std::vector<typename Patch<T>::Change> const &changes, size_t begin, size_t end, F &f,
+                              L &&lower) -> void {
+    auto m = changes_before_(changes, begin);
+    auto lower_ind = begin - m;
+    auto ind = begin;
+    while (ind < end) {
+      if (m < changes.size() && changes[m].ind + m == ind) {
+        f(std::span<const T>(&changes[m].value, 1UZ));
+        ++m;
+        ++ind;
+        continue;
+      }
+
+      auto next_ind = m < changes.size() ? std::min(changes[m].ind + m, end) : end;
+      lower(lower_ind, lower_ind + (next_ind - ind));
+      lower_ind += next_ind - ind;
+      ind = next_ind;
     }
+  }
 
-    base_ = std::move(new_base);
-    patches_.clear();
+  // Emits the kept base elements [begin, end), the runs between two removals come out as one span each.
+  template <typename F>
+  auto base_segments_(size_t begin, size_t end, F &f) const -> void {
+    auto raw_ind = raw_index_(begin);
+    if (patches_.empty() || patches_.front().removals_.empty()) {
+      f(std::span<const T>(base_->data() + raw_ind, end - begin));
+      return;
+    }
+
+    auto &removals = patches_.front().removals_;
+    auto r = static_cast<size_t>(std::ranges::lower_bound(removals, raw_ind) - removals.begin());
+    auto remaining = end - begin;
+    while (remaining > 0) {
+      auto run_end = r < removals.size() ? removals[r] : base_->size();
+      auto len = std::min(run_end - raw_ind, remaining);
+      if (len > 0) {
+        f(std::span<const T>(base_->data() + raw_ind, len));
+        remaining -= len;
+      }
+      raw_ind = run_end + 1UZ;
+      ++r;
+    }
   }
 
- private:
-  std::vector<T> base_;
+  // Index into the base of the kept base element ind. The j-th removal has removals[j] - j kept elements in front of
+  // it, so the removals to skip are found with one binary search.
+  auto raw_index_(size_t ind) const -> size_t {
+    if (patches_.empty()) return ind;
+
+    auto &removals = patches_.front().removals_;
+    auto lo = 0UZ;
+    auto hi = removals.size();
+    while (lo < hi) {
+      auto mid = lo + (hi - lo) / 2UZ;
+      if (removals[mid] - mid <= ind) {
+        lo = mid + 1UZ;
+      } else {
+        hi = mid;
+      }
+    }
+
+    return ind + lo;
+  }
+
+  // Number of changes that end up in front of the position ind of the level the patch produces.
+  static auto changes_before_(std::vector<typename Patch<T>::Change> const &changes, size_t ind) -> size_t {
+    auto lo = 0UZ;
+    auto hi = changes.size();
+    while (lo < hi) {
+      auto mid = lo + (hi - lo) / 2UZ;
+      if (changes[mid].ind + mid < ind) {
+        lo = mid + 1UZ;
+      } else {
+        hi = mid;
+      }
+    }
+
+    return lo;
+  }
+
+  // The base and the view are reference counted, so copying a PatchableVector only copies its patches.
+  std::shared_ptr<std::vector<T>> base_ = std::make_shared<std::vector<T>>();
   std::vector<Patch<T>> patches_;
+
+  mutable std::shared_ptr<std::vector<T>> view_;
+  mutable bool view_valid_ = false;
 };
 
 // ------------------------------------------------------------------------------------------------------
 // ----------------------------------------------- Detail -----------------------------------------------
 // ------------------------------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, size_t MaxDepth>
 template <typename V>
-PatchableVector<T>::Iterator<V>::Iterator()
-    : current_value_(nullptr), base_ind_(0UZ), started_base_(false), base_(nullptr), patches_(nullptr) {}
-
-template <typename T>
+PatchableVector<T, MaxDepth>::Iterator<V>::Iterator()
+    : current_value_(nullptr),
+      base_ind_(0UZ),
+      started_base_(false),
+      removals_(nullptr),
+      removal_index_(0UZ),
+      depth_(0UZ),
+      base_(nullptr),
+      patches_(nullptr) {}
+
+template <typename T, size_t MaxDepth>
 template <typename V>
-PatchableVector<T>::Iterator<V>::Iterator(size_t base_ind, bool started_base, std::vector<PatchInfo> &&patch_info,
-                                          BaseVecPtr base, PatchVecPtr patches)
+PatchableVector<T, MaxDepth>::Iterator<V>::Iterator(size_t base_ind, bool started_base, PatchInfoStorage &&patch_info,
+                                                    BaseVecPtr base, PatchVecPtr patches)
     : current_value_(nullptr),
       base_ind_(base_ind),
       started_base_(started_base),
-      patch_info_(patch_info),
+      removals_(patches->empty() ? nullptr : &patches->front().removals_),
+      removal_index_(0UZ),
+      depth_(patches->size()),
+      patch_info_(std::move(patch_info)),
       base_(base),
       patches_(patches) {
-  if (patches->size() > 0) {
-    for (auto i = patches_->size(); i-- > 0;) {
+  assert(depth_ <= MaxDepth);
+  if (removals_ != nullptr) {
+    removal_index_ = static_cast<size_t>(std::ranges::lower_bound(*removals_, base_ind_) - removals_->begin());
+  }
+
+  if (depth_ > 0) {
+    for (auto i = depth_; i-- > 0;) {
       patch_info_[i].started = true;
       if (patch_info_[i].change_index > 0 && prev_change_(i).ind == patch_info_[i].index) {
         current_value_ = &prev_change_(i).value;
@@ -247,6 +613,7 @@ PatchableVector<T>::Iterator<V>::Iterator(size_t base_ind, bool started_base, st
   }
 
   started_base_ = true;
+  skip_removed_();
   if (base_ind_ < base_->size()) {
     current_value_ = &(*base)[base_ind_];
   } else {
@@ -254,11 +621,11 @@ PatchableVector<T>::Iterator<V>::Iterator(size_t base_ind, bool started_base, st
   }
 }
 
-template <typename T>
+template <typename T, size_t MaxDepth>
 template <typename V>
-auto PatchableVector<T>::Iterator<V>::operator++() -> Iterator<V> & {
-  if (patches_->size() > 0) {
-    for (auto i = patches_->size(); i-- > 0;) {
+auto PatchableVector<T, MaxDepth>::Iterator<V>::operator++() -> Iterator<V> & {
+  if (depth_ > 0) {
+    for (auto i = depth_; i-- > 0;) {
       if (!patch_info_[i].started) {
         patch_info_[i].started = true;
       } else {
@@ -278,6 +645,7 @@ auto PatchableVector<T>::Iterator<V>::operator++() -> Iterator<V> & {
   } else {
     base_ind_++;
   }
+  skip_removed_();
   if (base_ind_ < base_->size()) {
     current_value_ = &(*base_)[base_ind_];
   } else {
@@ -287,11 +655,11 @@ auto PatchableVector<T>::Iterator<V>::operator++() -> Iterator<V> & {
   return *this;
 }
 
-template <typename T>
+template <typename T, size_t MaxDepth>
 template <typename V>
-auto PatchableVector<T>::Iterator<V>::operator--() -> Iterator<V> & {
-  if (patches_->size() > 0) {
-    for (auto i = patches_->size(); i-- > 0;) {
+auto PatchableVector<T, MaxDepth>::Iterator<V>::operator--() -> Iterator<V> & {
+  if (depth_ > 0) {
+    for (auto i = depth_; i-- > 0;) {
       if (patch_info_[i].index == 0) {
         started_base_ = false;
         for (auto j = i + 1UZ; j-- > 0;) {
@@ -319,10 +687,8 @@ auto PatchableVector<T>::Iterator<V>::operator--() -> Iterator<V> & {
     }
   }
 
-  if (base_ind_ == 0) {
+  if (!step_base_back_()) {
     started_base_ = false;
-  } else {
-    base_ind_--;
   }
 
   current_value_ = find_prev_value_();
@@ -330,26 +696,26 @@ auto PatchableVector<T>::Iterator<V>::operator--() -> Iterator<V> & {
   return *this;
 }
 
-template <typename T>
+template <typename T, size_t MaxDepth>
 template <typename V>
-auto PatchableVector<T>::Iterator<V>::operator++(int) -> Iterator<V> {
+auto PatchableVector<T, MaxDepth>::Iterator<V>::operator++(int) -> Iterator<V> {
   auto tmp = *this;
   ++(*this);
   return tmp;
 }
 
-template <typename T>
+template <typename T, size_t MaxDepth>
 template <typename V>
-auto PatchableVector<T>::Iterator<V>::operator--(int) -> Iterator<V> {
+auto PatchableVector<T, MaxDepth>::Iterator<V>::operator--(int) -> Iterator<V> {
   auto tmp = *this;
   --(*this);
   return tmp;
 }
 
-template <typename T>
+template <typename T, size_t MaxDepth>
 template <typename V>
-auto PatchableVector<T>::Iterator<V>::find_prev_value_() -> pointer {
-  for (auto i = patches_->size(); i-- > 0;) {
+auto PatchableVector<T, MaxDepth>::Iterator<V>::find_prev_value_() -> pointer {
+  for (auto i = depth_; i-- > 0;) {
     if (!predecessor_started_(i) ||
         (patch_info_[i].change_index > 0 && predecessor_ind_(i) + 1UZ == prev_change_(i).ind)) {
       return &prev_change_(i).value;
@@ -359,4 +725,34 @@ auto PatchableVector<T>::Iterator<V>::find_prev_value_() -> pointer {
   return &(*base_)[base_ind_];
 }
 
-}  // namespace cye
\ No newline at end of file
+template <typename T, size_t MaxDepth>
+template <typename V>
+auto PatchableVector<T, MaxDepth>::Iterator<V>::skip_removed_() -> void {
+  while (has_removal_(removal_index_) && (*removals_)[removal_index_] == base_ind_) {
+    base_ind_++;
+    removal_index_++;
+  }
+}
+
+// Moves base_ind_ to the previous kept base element. Returns false and leaves base_ind_ in place if there is none.
+template <typename T, size_t MaxDepth>
+template <typename V>
+auto PatchableVector<T, MaxDepth>::Iterator<V>::step_base_back_() -> bool {
+  auto ind = base_ind_;
+  auto removal_ind = removal_index_;
+  while (ind > 0) {
+    --ind;
+    if (removal_ind > 0 && (*removals_)[removal_ind - 1UZ] == ind) {
+      --removal_ind;
+      continue;
+    }
+
+    base_ind_ = ind;
+    removal_index_ = removal_ind;
+    return true;
+  }
+
+  return false;
+}
+
+}  // namespace cye
@@ -1,20 +1,146 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <optional>
-#include <queue>
+#include <span>
 #include <unordered_map>
 #include <vector>
 #include "cye/instance.hpp"
+#include "cye/route_cache.hpp"
 #include "cye/solution.hpp"
 
 namespace cye {
 
+// Scratch table of patch_cargo_optimally. It is one flat allocation with the bins of a node next to each other, and it
+// only grows, so repeated repairs stop going through the allocator. The backpointers live apart from the distances,
+// each packed with the depot detour flag into 32 bits.
+class CargoDPWorkspace {
+ public:
+  // Sizes the table for bin_cnt bins and column_cnt nodes and sets every distance to infinity. The backpointers are
+  // left as they are, the traceback only reads cells that got a finite distance.
+  auto reset(unsigned bin_cnt, size_t column_cnt) -> void;
+
+  [[nodiscard]] inline auto column(size_t j) -> std::span<double> {
+    return std::span<double>(dist_.data() + j * bin_cnt_, bin_cnt_);
+  }
+  [[nodiscard]] inline auto dist(unsigned i, size_t j) const { return dist_[j * bin_cnt_ + i]; }
+  [[nodiscard]] inline auto prev(unsigned i, size_t j) const { return back_[j * bin_cnt_ + i] >> 1u; }
+  [[nodiscard]] inline auto inserted(unsigned i, size_t j) const -> bool { return back_[j * bin_cnt_ + i] & 1u; }
+  inline auto set_back(unsigned i, size_t j, unsigned prev, bool inserted) {
+    back_[j * bin_cnt_ + i] = (prev << 1u) | static_cast<uint32_t>(inserted);
+  }
+
+  // Bytes held by the table, including capacity left over from larger instances.
+  [[nodiscard]] inline auto memory_usage() const {
+    return dist_.capacity() * sizeof(double) + back_.capacity() * sizeof(uint32_t);
+  }
+
+ private:
+  size_t bin_cnt_ = 0UZ;
+  std::vector<double> dist_;
+  std::vector<uint32_t> back_;
+};
+
+// Scratch labels of the sparse patch_cargo_optimally. Every node keeps only its Pareto front of (remaining cargo,
+// distance) states, sorted by remaining cargo, so the work tracks the number of reachable states and not the capacity.
+class CargoLabelWorkspace {
+ public:
+  struct Label {
+    double cargo;
+    double dist;
+    // Position of the parent label in the front of the previous node
+    uint32_t parent;
+    bool inserted;
+  };
+
+  inline auto clear() {
+    labels_.clear();
+    offsets_.clear();
+    offsets_.push_back(0UZ);
+  }
+  // Makes room for label_cnt more labels, growing geometrically like push_back would.
+  inline auto reserve(size_t label_cnt) {
+    if (labels_.size() + label_cnt > labels_.capacity()) {
+      labels_.reserve(std::max(2 * labels_.capacity(), labels_.size() + label_cnt));
+    }
+  }
+  inline auto push_back(Label const &label) { labels_.push_back(label); }
+  inline auto pop_back() { labels_.pop_back(); }
+  // Closes the front that is currently being built.
+  inline auto finish_front() { offsets_.push_back(labels_.size()); }
+
+  [[nodiscard]] inline auto front(size_t j) const {
+    return std::span<const Label>(labels_.data() + offsets_[j], offsets_[j + 1] - offsets_[j]);
+  }
+  // The front that is currently being built.
+  [[nodiscard]] inline auto open_front() const {
+    return std::span<const Label>(labels_.data() + offsets_.back(), labels_.size() - offsets_.back());
+  }
+  [[nodiscard]] inline auto front_cnt() const { return offsets_.size() - 1; }
+  [[nodiscard]] inline auto label_cnt() const { return labels_.size(); }
+
+  // Sets aside every front from front_cnt on, so a tour edited past that point can be relaxed again from there.
+  auto retire(size_t front_cnt) -> void;
+  // The constant by which the distances of front j differ from the retired front j, if they agree otherwise.
+  [[nodiscard]] auto shift_from_retired(size_t j) const -> std::optional<double>;
+  // Appends the retired fronts from j on, with their distances shifted.
+  auto restore_retired(size_t j, double shift) -> void;
+
+  [[nodiscard]] inline auto memory_usage() const {
+    return (labels_.capacity() + retired_labels_.capacity()) * sizeof(Label) +
+           (offsets_.capacity() + retired_offsets_.capacity()) * sizeof(size_t);
+  }
+
+ private:
+  std::vector<Label> labels_;
+  std::vector<size_t> offsets_;
+  std::vector<Label> retired_labels_;
+  std::vector<size_t> retired_offsets_;
+  size_t retired_first_ = 0UZ;
+};
+
+// Uses a workspace owned by the calling thread.
 auto patch_cargo_optimally(Solution &solution, unsigned bin_cnt) -> void;
-inline auto patch_cargo_optimally(Solution &solution) -> void {
-  patch_cargo_optimally(solution, static_cast<unsigned>(solution.instance().cargo_capacity()) + 1u);
-}
+auto patch_cargo_optimally(Solution &solution, unsigned bin_cnt, CargoDPWorkspace &workspace) -> void;
+// Exact in the cargo, without bins. Uses a workspace owned by the calling thread.
+auto patch_cargo_optimally(Solution &solution) -> void;
+auto patch_cargo_optimally(Solution &solution, CargoLabelWorkspace &workspace) -> void;
+// Repairs a tour of the same length as the one the workspace was last filled for, which differs from it only in
+// positions first_changed to last_changed. Passing a first_changed past the tour only traces back.
+auto patch_cargo_optimally(Solution &solution, CargoLabelWorkspace &workspace, size_t first_changed,
+                           size_t last_changed) -> void;
+
+// Scratch arrays of fleet_split and linear_split. They only grow, so splitting many tours of one instance stops going
+// through the allocator.
+struct SplitWorkspace {
+  auto reset(size_t customer_cnt, size_t max_route_cnt) -> void;
+  [[nodiscard]] auto memory_usage() const -> size_t;
+
+  // Distance travelled along the tour from its first customer to customer t
+  std::vector<double> distance;
+  // Demand of the first t customers
+  std::vector<double> load;
+  // Row k holds the cheapest way to serve the first t customers with exactly k routes
+  std::vector<double> cost;
+  std::vector<size_t> pred;
+  std::vector<size_t> queue;
+};
+
+// Exact split of a giant tour into at most max_route_cnt routes in O(n * max_route_cnt). Returns false and leaves the
+// solution untouched if the tour cannot be served with that many vehicles.
+auto fleet_split(Solution &solution, size_t max_route_cnt) -> bool;
+auto fleet_split(Solution &solution, size_t max_route_cnt, SplitWorkspace &workspace) -> bool;
+
+// Exact split of a giant tour with an unlimited fleet in O(n). Uses a workspace owned by the calling thread.
 auto linear_split(Solution &solution) -> void;
+auto linear_split(Solution &solution, SplitWorkspace &workspace) -> void;
+// Splits every solution, on one thread per workspace. Solution i goes to workspace i % workspaces.size(), so once the
+// workspaces have grown to the instance nothing is allocated but the threads.
+auto linear_split(std::span<Solution> solutions, std::span<SplitWorkspace> workspaces) -> void;
 
 auto patch_cargo_trivially(Solution &solution) -> void;
 auto patch_energy_trivially(Solution &solution) -> void;
@@ -32,38 +158,145 @@ struct DPCell {
   uint16_t exit_ind;
 };
 
-class OptimalEnergyRepair {
+// Shortest paths between the depot (index 0) and the charging stations. Immutable once built, so a single copy can
+// serve every repair and thread.
+class StationNetwork {
  public:
-  OptimalEnergyRepair(std::shared_ptr<Instance> instance);
-  auto patch(Solution &solution, unsigned bin_cnt) -> void;
-  auto fill_dp(Solution &solution, unsigned bin_cnt) -> std::vector<std::vector<DPCell>>;
+  explicit StationNetwork(std::shared_ptr<Instance> instance);
 
- private:
-  auto compute_cs_dist_mat_() -> void;
-  auto find_between_(size_t start_node_id, size_t goal_node_id) -> std::optional<std::pair<std::vector<size_t>, double>>;
-  auto reset_() -> void;
+  // A way to charge between two nodes, entering the station network at entry_ind and leaving it at exit_ind
+  struct StationPair {
+    double energy_to_entry;
+    double energy_from_exit;
+    double dist;
+    uint16_t entry_ind;
+    uint16_t exit_ind;
+  };
+
+  [[nodiscard]] inline auto &instance() const { return *instance_; }
+  [[nodiscard]] inline auto instance_ptr() const { return instance_; }
+  // Unique among the networks of a process, workspaces use it to tell whose station pairs they hold
+  [[nodiscard]] inline auto id() const { return id_; }
+
+  // The station pairs worth trying on an edge, sorted by the energy needed to reach the entry
+  [[nodiscard]] auto station_pairs(size_t previous_node_id, size_t current_node_id) const -> std::vector<StationPair>;
+  // Adds the stations on the shortest path from entry_ind to exit_ind before position j, back to front
+  auto add_charging_detour(Patch<size_t> &patch, size_t j, uint16_t entry_ind, uint16_t exit_ind) const -> void;
 
+ private:
   std::shared_ptr<Instance> instance_;
+  size_t id_;
   std::vector<std::vector<double>> cs_dist_mat_;
+  // The next station on the shortest path from i to j
+  std::vector<std::vector<uint16_t>> cs_next_hop_;
+};
+
+// Scratch memory of OptimalEnergyRepair. Threads that repair at the same time need a workspace each.
+class EnergyRepairWorkspace {
+ private:
+  friend class OptimalEnergyRepair;
 
-  struct VisitedNode_ {
-    double g;
-    size_t parent;
+  struct EnergyLabel_ {
+    double energy;
+    double dist;
+    // Position of the parent label in the front of the previous node
+    uint32_t parent;
+    uint16_t entry_ind;
+    uint16_t exit_ind;
   };
 
-  struct UnvisitedNode_ {
-    size_t node_id;
-    size_t parent;
-    double g;
-    double h;
+  // A bin of a binned DP column, reached from bin prev of the column before
+  struct BinLabel_ {
+    double dist;
+    uint32_t bin;
+    uint32_t prev;
+    uint16_t entry_ind;
+    uint16_t exit_ind;
   };
 
-  constexpr static auto cmp_ = [](UnvisitedNode_ const &a, UnvisitedNode_ const &b) {
-    return (a.g + a.h) > (b.g + b.h);
+  // Station pairs of the edges repaired so far, computed the first time an edge is repaired
+  auto station_pairs_(StationNetwork const &network, size_t previous_node_id, size_t current_node_id)
+      -> std::span<const StationNetwork::StationPair>;
+
+  // Fronts of every node, one after another
+  std::vector<EnergyLabel_> labels_;
+  std::vector<size_t> offsets_;
+  std::vector<EnergyLabel_> candidates_;
+  std::vector<size_t> node_ids_;
+  std::vector<ChargingDetour> detours_;
+
+  size_t network_id_{std::numeric_limits<size_t>::max()};
+  std::unordered_map<size_t, std::vector<StationNetwork::StationPair>> station_pairs_cache_;
+
+  // Bins of every column no higher bin beats in distance, in increasing order and one column after another
+  std::vector<BinLabel_> bin_labels_;
+  std::vector<size_t> bin_offsets_;
+  std::vector<BinLabel_> bin_candidates_;
+
+  // Smallest distance of the previous column from each bin up, and the bin it is found in
+  std::vector<double> suffix_dist_;
+  std::vector<uint32_t> suffix_bin_;
+};
+
+// Holds nothing but the shared network and route cache, so one repair can be used from any number of threads. The
+// overloads without a workspace use one of the calling thread.
+class OptimalEnergyRepair {
+ public:
+  // Repairs of single routes go through route_cache, pass the same cache to every repair of a population to share them
+  OptimalEnergyRepair(std::shared_ptr<Instance> instance, std::shared_ptr<RouteCache> route_cache = nullptr);
+  OptimalEnergyRepair(std::shared_ptr<const StationNetwork> network, std::shared_ptr<RouteCache> route_cache = nullptr);
+
+  // Exact in the battery. Every node keeps the Pareto front of (remaining energy, distance) labels it can be reached
+  // with, so no bin count is involved.
+  auto patch(Solution &solution) const -> void;
+  auto patch(Solution &solution, EnergyRepairWorkspace &workspace) const -> void;
+  // Same as patch(solution), route by route. The battery is full again at the depot, so every route is repaired on
+  // its own, and a route that was repaired before reuses its detours. Routes the battery drives through as they are
+  // skip the DP. Returns the cost of the repaired solution.
+  auto patch_routes(Solution &solution) const -> double;
+  auto patch_routes(Solution &solution, EnergyRepairWorkspace &workspace) const -> double;
+
+  [[nodiscard]] inline auto &network() const { return network_; }
+  [[nodiscard]] inline auto &route_cache() const { return route_cache_; }
+  // Keeps the DP table under memory_budget bytes by storing only every few columns and recomputing the rest during
+  // the traceback. Columns only hold the bins no higher bin beats in distance, the others cannot be on a cheapest
+  // path.
+  auto patch(Solution &solution, unsigned bin_cnt, size_t memory_budget = std::numeric_limits<size_t>::max()) const
+      -> void;
+  // The full table with every bin, as patch would see it without pruning
+  auto fill_dp(Solution &solution, unsigned bin_cnt) const -> std::vector<std::vector<DPCell>>;
+
+ private:
+  // The binned table, one array per field so the relaxation runs over contiguous bins. Column j starts at j * bin_cnt.
+  struct DPTable_ {
+    auto resize(size_t column_cnt, unsigned bin_cnt) -> void;
+
+    std::vector<double> dist;
+    std::vector<uint32_t> prev;
+    std::vector<uint16_t> entry_ind;
+    std::vector<uint16_t> exit_ind;
   };
 
-  std::unordered_map<size_t, VisitedNode_> visited_;
-  std::priority_queue<UnvisitedNode_, std::vector<UnvisitedNode_>, decltype(cmp_)> unvisited_queue_;
+  // Fills column current_column of the table from the column before it
+  auto relax_(EnergyRepairWorkspace &workspace, size_t previous_node_id, size_t current_node_id, unsigned bin_cnt,
+              DPTable_ &table, size_t current_column) const -> void;
+  // Builds the pruned column of current_node_id from the last one in the workspace
+  auto extend_bin_front_(EnergyRepairWorkspace &workspace, size_t previous_node_id, size_t current_node_id,
+                         unsigned bin_cnt) const -> void;
+  static auto checkpoint_interval_(size_t column_cnt, unsigned bin_cnt, size_t memory_budget) -> size_t;
+  auto extend_front_(EnergyRepairWorkspace &workspace, size_t previous_node_id, size_t current_node_id) const -> void;
+
+  // Runs the label DP over node_ids, which start at the depot, appends the detours back to front and returns the
+  // distance driven
+  auto solve_labels_(EnergyRepairWorkspace &workspace, std::span<const size_t> node_ids,
+                     std::vector<ChargingDetour> &detours) const -> double;
+  static auto gather_node_ids_(Solution const &solution, std::vector<size_t> &node_ids) -> void;
+  // The distance of a route that starts at the depot if it needs no detour, or infinity if it does
+  [[nodiscard]] auto distance_without_detours_(std::span<const size_t> route) const -> double;
+
+  std::shared_ptr<const StationNetwork> network_;
+  std::shared_ptr<Instance> instance_;
+  std::shared_ptr<RouteCache> route_cache_;
 };
 
 }  // namespace cye
\ No newline at end of file
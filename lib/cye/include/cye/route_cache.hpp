@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace cye {
+
+// A charging detour inserted before the node at position, entering the station network at entry_ind and leaving it
+// at exit_ind
+struct ChargingDetour {
+  size_t position;
+  uint16_t entry_ind;
+  uint16_t exit_ind;
+};
+
+// Energy repairs of single routes, shared by every evaluator of a population. The routes are split between shards
+// with a lock each, and every shard evicts with a CLOCK sweep once it goes over its share of the memory budget.
+// Routes are keyed by the station network they were repaired on too, so repairs of different instances can share a
+// cache.
+class RouteCache {
+ public:
+  RouteCache(size_t memory_budget = 64UZ << 20, size_t shard_cnt = 16);
+
+  [[nodiscard]] static auto hash(size_t network_id, std::span<const size_t> route) -> size_t;
+
+  // Copies the detours and the cost of the route into detours and cost, returns false if the route is not cached
+  auto find(size_t network_id, size_t hash, std::span<const size_t> route, std::vector<ChargingDetour> &detours,
+            double &cost) -> bool;
+  auto insert(size_t network_id, size_t hash, std::span<const size_t> route, std::span<const ChargingDetour> detours,
+              double cost) -> void;
+  auto clear() -> void;
+
+  [[nodiscard]] inline auto hit_cnt() const { return hit_cnt_.load(std::memory_order_relaxed); }
+  [[nodiscard]] inline auto miss_cnt() const { return miss_cnt_.load(std::memory_order_relaxed); }
+  [[nodiscard]] auto hit_rate() const -> double;
+  [[nodiscard]] auto route_cnt() const -> size_t;
+  [[nodiscard]] auto memory_usage() const -> size_t;
+
+ private:
+  struct Slot_ {
+    size_t network_id;
+    size_t hash;
+    std::vector<size_t> route;
+    std::vector<ChargingDetour> detours;
+    double cost;
+    // Set on every hit, the clock hand clears it once before evicting the slot
+    bool referenced;
+    bool occupied;
+  };
+
+  struct Shard_ {
+    mutable std::mutex mutex;
+    std::unordered_map<size_t, size_t> slot_inds;
+    std::vector<Slot_> slots;
+    std::vector<size_t> free_slot_inds;
+    size_t hand{0};
+    size_t memory_usage{0};
+  };
+
+  [[nodiscard]] static auto slot_memory_(Slot_ const &slot) -> size_t;
+  auto shard_(size_t hash) -> Shard_ &;
+  auto evict_(Shard_ &shard, size_t kept_slot_ind) -> void;
+
+  size_t shard_memory_budget_;
+  std::vector<Shard_> shards_;
+  std::atomic<size_t> hit_cnt_{0};
+  std::atomic<size_t> miss_cnt_{0};
+};
+
+}  // namespace cye
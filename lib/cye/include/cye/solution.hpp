@@ -8,10 +8,14 @@
 
 namespace cye {
 
+// Routes carry at most a few patches (cargo, energy), bounding the depth keeps route iterators off the heap.
+inline constexpr auto max_route_patch_depth = 4UZ;
+using Routes = PatchableVector<size_t, max_route_patch_depth>;
+
 class Solution {
  public:
   Solution(std::shared_ptr<Instance> instance, std::vector<size_t> &&routes);
-  Solution(std::shared_ptr<Instance> instance, PatchableVector<size_t> &&routes);
+  Solution(std::shared_ptr<Instance> instance, Routes &&routes);
   Solution(std::shared_ptr<Instance> instance, std::vector<size_t> &&routes,
            std::vector<size_t> &&unassigned_customers);
 
@@ -19,6 +23,8 @@ class Solution {
 
   inline auto squash() { routes_.squash(); }
 
+  inline auto merge_patches() { routes_.merge_patches(); }
+
   inline auto clear_patches() { routes_.clear_patches(); }
 
   inline auto pop_patch() { return routes_.pop_patch(); }
@@ -33,6 +39,7 @@ class Solution {
   [[nodiscard]] inline auto &routes() const { return routes_; }
   [[nodiscard]] inline auto visited_node_cnt() const { return routes_.size(); }
 
+  // These only read the routes, a solution can be checked from several threads at once.
   [[nodiscard]] auto is_cargo_valid() const -> bool;
   [[nodiscard]] auto is_energy_and_cargo_valid() const -> bool;
   [[nodiscard]] auto is_valid() const -> bool;
@@ -46,7 +53,7 @@ class Solution {
 
  private:
   std::shared_ptr<Instance> instance_;
-  PatchableVector<size_t> routes_;
+  Routes routes_;
 };
 
 }  // namespace cye
\ No newline at end of file
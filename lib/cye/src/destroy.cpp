@@ -1,6 +1,7 @@
 #include "cye/destroy.hpp"
 
 #include <random>
+#include <utility>
 #include "cye/solution.hpp"
 
 namespace cye {
@@ -12,19 +13,20 @@ Solution random_destroy(Solution &&solution, meta::RandomEngine &gen, double max
   auto destroy_rate_dist = std::uniform_real_distribution(0.0, max_destroy_rate);
   auto destroy_rate = destroy_rate_dist(gen);
 
-  std::vector<size_t> new_routes;
-  std::vector<size_t> unassigned;
-  for (auto node_id : solution.routes()) {
-    if (instance.is_customer(node_id)) {
-      if (dist(gen) < destroy_rate) {
-        unassigned.push_back(node_id);
-      } else {
-        new_routes.push_back(node_id);
-      }
+  // The repairs add their depots and charging stations back as patches, so a removal patch hides them along with the
+  // destroyed customers instead of building a new route vector, and only the remaining customers stay visible.
+  solution.clear_patches();
+
+  auto patch = Patch<size_t>();
+  auto &base = std::as_const(solution).base();
+  for (auto i = 0UZ; i < base.size(); ++i) {
+    if (!instance.is_customer(base[i]) || dist(gen) < destroy_rate) {
+      patch.add_removal(i);
     }
   }
+  solution.add_patch(std::move(patch));
 
-  return cye::Solution(solution.instance_ptr(), std::move(new_routes), std::move(unassigned));
+  return std::move(solution);
 }
 
 }  // namespace cye
\ No newline at end of file
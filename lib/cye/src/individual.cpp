@@ -1,33 +1,99 @@
 #include "cye/individual.hpp"
 #include "cye/repair.hpp"
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
 
-cye::EVRPIndividual::EVRPIndividual(std::shared_ptr<cye::OptimalEnergyRepair> energy_repair, cye::Solution &&solution)
-    : energy_repair_(energy_repair), solution_(std::move(solution)), valid_(false) {
+cye::EVRPIndividual::EVRPIndividual(std::shared_ptr<cye::OptimalEnergyRepair> energy_repair, cye::Solution &&solution,
+                                    std::optional<size_t> max_route_cnt)
+    : energy_repair_(energy_repair), solution_(std::move(solution)), max_route_cnt_(max_route_cnt), valid_(false) {
   update_cost();
 }
 
 auto cye::EVRPIndividual::update_cost() -> void {
+  // The route cache knows the cost of every route it repairs, so only the other paths sum up the distances
+  auto repaired_cost = std::optional<double>();
   if (!valid_) {
-    solution_.clear_patches();
     if (trivial_) {
+      solution_.clear_patches();
       cye::patch_cargo_trivially(solution_);
       cye::patch_energy_trivially(solution_);
     } else {
-      cye::patch_cargo_optimally(solution_, static_cast<unsigned>(solution_.instance().cargo_capacity()) + 1u);
-      energy_repair_->patch(solution_, 101u);
+      split_cargo();
+
+      // The split without a limit is the shortest one, the fleet-limited split only runs when it needs too many routes
+      // and falls back to it when the fleet cannot serve the tour
+      auto route_cnt = solution_.get_patch(0).changes().size() - 1;
+      if (max_route_cnt_ && route_cnt > *max_route_cnt_) {
+        solution_.clear_patches();
+        if (!cye::fleet_split(solution_, *max_route_cnt_)) {
+          split_cargo();
+        }
+      }
+      repaired_cost = energy_repair_->patch_routes(solution_);
     }
     valid_ = true;
   }
 
   cost_ = 0.f;
-  auto previous_node_id = *solution_.routes().begin();
+  // The distance of a node to itself is zero, so seeding with the first node makes the walk start for free
+  auto &routes = solution_.routes();
+  auto previous_node_id = routes[0];
   hash_ = 14695981039346656037u;
-  for (auto it = ++solution_.routes().begin(); it != solution_.routes().end(); ++it) {
-    auto current_node_id = *it;
-    cost_ += solution_.instance().distance(previous_node_id, current_node_id);
-    previous_node_id = current_node_id;
+  routes.for_each_segment([&](std::span<const size_t> segment) {
+    for (auto current_node_id : segment) {
+      if (!repaired_cost) {
+        cost_ += solution_.instance().distance(previous_node_id, current_node_id);
+      }
+      previous_node_id = current_node_id;
 
-    hash_ *= fnv_prime_;
-    hash_ ^= std::hash<size_t>{}(current_node_id);
+      hash_ *= fnv_prime_;
+      hash_ ^= std::hash<size_t>{}(current_node_id);
+    }
+  });
+  if (repaired_cost) {
+    cost_ = *repaired_cost;
   }
-}
\ No newline at end of file
+}
+
+namespace {
+
+// Label fronts of the last cargo split of the thread and the tour they were computed for. Individuals only hold their
+// genotype, so copying them stays cheap.
+struct CargoSplitCache {
+  cye::CargoLabelWorkspace labels;
+  // Weak, so the address of a freed instance cannot be mistaken for a new one
+  std::weak_ptr<cye::Instance> instance;
+  std::vector<size_t> routes;
+};
+
+thread_local auto cargo_split_cache = CargoSplitCache();
+
+}  // namespace
+
+auto cye::EVRPIndividual::split_cargo() -> void {
+  solution_.clear_patches();
+  const auto &routes = std::as_const(solution_).base();
+  auto &cache = cargo_split_cache;
+  auto &split_routes = cache.routes;
+
+  auto same_instance = cache.instance.lock() == solution_.instance_ptr();
+  if (same_instance && !split_routes.empty() && routes.size() == split_routes.size()) {
+    auto first_changed = static_cast<size_t>(std::ranges::mismatch(routes, split_routes).in1 - routes.begin());
+    auto last_changed = first_changed;
+    if (first_changed < routes.size()) {
+      auto [rit, _] = std::ranges::mismatch(routes | std::views::reverse, split_routes | std::views::reverse);
+      last_changed = routes.size() - 1 - static_cast<size_t>(rit - routes.rbegin());
+    }
+    cye::patch_cargo_optimally(solution_, cache.labels, first_changed, last_changed);
+  } else {
+    cye::patch_cargo_optimally(solution_, cache.labels);
+  }
+
+  cache.instance = solution_.instance_ptr();
+  split_routes.assign(routes.begin(), routes.end());
+}
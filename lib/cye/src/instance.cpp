@@ -1,5 +1,9 @@
 #include "cye/instance.hpp"
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
 #include <vector>
 
 
@@ -15,4 +19,46 @@ auto cye::Instance::update_distance_cache_() -> void {
       distance_cache_[node2_id * (node2_id + 1) / 2 + node1_id] = dist;
     }
   }
-}
\ No newline at end of file
+}
+
+auto cye::Instance::update_cargo_quantum_() -> void {
+  auto is_whole = [](double value) { return value >= 0.0 && std::floor(value) == value; };
+
+  cargo_quantum_ = 1.0;
+  if (!is_whole(cargo_capacity_)) return;
+
+  auto quantum = static_cast<uint64_t>(cargo_capacity_);
+  for (auto customer_id : customer_ids()) {
+    auto demand = nodes_[customer_id].demand;
+    if (!is_whole(demand)) return;
+    quantum = std::gcd(quantum, static_cast<uint64_t>(demand));
+  }
+
+  if (quantum > 0) {
+    cargo_quantum_ = static_cast<double>(quantum);
+  }
+}
+
+auto cye::Instance::update_reachable_stations_() -> void {
+  reachable_station_ids_.clear();
+  reachable_station_offsets_.assign(1, 0UZ);
+
+  for (auto node_id = 0UZ; node_id < nodes_.size(); ++node_id) {
+    auto first = reachable_station_ids_.size();
+    if (node_id != depot_id() && energy_required(node_id, depot_id()) <= battery_capacity_) {
+      reachable_station_ids_.push_back(depot_id());
+    }
+    for (auto station_id : charging_station_ids()) {
+      if (station_id != node_id && energy_required(node_id, station_id) <= battery_capacity_) {
+        reachable_station_ids_.push_back(station_id);
+      }
+    }
+
+    std::ranges::sort(reachable_station_ids_.begin() + static_cast<std::ptrdiff_t>(first), reachable_station_ids_.end(),
+                      [&](size_t a, size_t b) {
+                        return distance(node_id, a) < distance(node_id, b) ||
+                               (distance(node_id, a) == distance(node_id, b) && a < b);
+                      });
+    reachable_station_offsets_.push_back(reachable_station_ids_.size());
+  }
+}
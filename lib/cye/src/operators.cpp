@@ -2,6 +2,7 @@
 #include <cstddef>
 #include <iostream>
 #include <random>
+#include <span>
 #include <stdexcept>
 #include <utility>
 #include "cye/individual.hpp"
@@ -91,12 +92,11 @@ auto cye::RouteOX1::crossover(meta::RandomEngine &gen, cye::EVRPIndividual const
 namespace {
 
 std::vector<size_t> convert_to_vector(cye::Solution const &sol) {
-    std::vector<size_t> v;
-    v.reserve(sol.visited_node_cnt() + 2);
-    for (auto it : sol.routes()) {
-      v.emplace_back(it);
-    }
-    return v;
+    auto routes = std::vector<size_t>();
+    routes.reserve(sol.visited_node_cnt());
+    sol.routes().for_each_segment(
+        [&](std::span<const size_t> segment) { routes.insert(routes.end(), segment.begin(), segment.end()); });
+    return routes;
 };
 
 inline bool is_better(double cost, double new_cost) {
@@ -203,10 +203,7 @@ std::vector<size_t> generate_shuffled_indices(size_t size, meta::RandomEngine &g
 
 bool DoFullSwapSearch(meta::RandomEngine &gen, cye::EVRPIndividual &individual, cye::Instance const *instance) {
   auto &solution = individual.solution();
-  std::vector<size_t> route;
-  for (auto it : solution.routes()) {
-    route.emplace_back(it);
-  }
+  auto route = convert_to_vector(solution);
 
   bool stop = false;
   bool found_improvement = false;
@@ -266,17 +263,13 @@ bool DoFullSwapSearch(meta::RandomEngine &gen, cye::EVRPIndividual &individual,
     }
   }
   solution = cye::Solution(solution.instance_ptr(), std::move(new_base));
-  solution.clear_patches();
-  cye::patch_cargo_optimally(solution);
+  individual.split_cargo();
   return found_improvement;
 }
 
 bool DoFullTwoOptSearch(meta::RandomEngine &gen, cye::EVRPIndividual &individual, cye::Instance const *instance) {
   auto &solution = individual.solution();
-  std::vector<size_t> route;
-  for (auto it : solution.routes()) {
-    route.emplace_back(it);
-  }
+  auto route = convert_to_vector(solution);
 
   bool stop = false;
   auto cost = solution.cost();
@@ -342,17 +335,13 @@ bool DoFullTwoOptSearch(meta::RandomEngine &gen, cye::EVRPIndividual &individual
     }
   }
   solution = cye::Solution(solution.instance_ptr(), std::move(new_base));
-  solution.clear_patches();
-  cye::patch_cargo_optimally(solution);
+  individual.split_cargo();
   return found_improvement;
 }
 
 bool DoFullMoveSearch(meta::RandomEngine &gen, cye::EVRPIndividual &individual, cye::Instance const *instance) {
   auto &solution = individual.solution();
-  std::vector<size_t> route;
-  for (auto it : solution.routes()) {
-    route.emplace_back(it);
-  }
+  auto route = convert_to_vector(solution);
 
   bool stop = false;
   bool found_improvement = false;
@@ -418,8 +407,7 @@ bool DoFullMoveSearch(meta::RandomEngine &gen, cye::EVRPIndividual &individual,
     }
   }
   solution = cye::Solution(solution.instance_ptr(), std::move(new_base));
-  solution.clear_patches();
-  cye::patch_cargo_optimally(solution);
+  individual.split_cargo();
 
   return found_improvement;
 }
@@ -430,12 +418,11 @@ bool DoFullMoveSearch(meta::RandomEngine &gen, cye::EVRPIndividual &individual,
 
 auto cye::TwoOptSearch::search(meta::RandomEngine &gen, cye::EVRPIndividual &&individual) -> cye::EVRPIndividual {
   auto &solution = individual.solution();
-  solution.clear_patches();
+  individual.split_cargo();
 
-  cye::patch_cargo_optimally(solution);
   DoTwoOpt(individual, instance_.get());
   // cye::patch_energy_removal_heuristic(solution);
-  energy_repair_->patch(solution, 151U);
+  energy_repair_->patch_routes(solution);
   // cye::patch_energy_trivially(solution);
   individual.set_valid();
 
@@ -445,9 +432,7 @@ auto cye::TwoOptSearch::search(meta::RandomEngine &gen, cye::EVRPIndividual &&in
 
 auto cye::SOTASearch::search(meta::RandomEngine &gen, cye::EVRPIndividual &&individual) -> cye::EVRPIndividual {
   auto &solution = individual.solution();
-  solution.clear_patches();
-
-  cye::patch_cargo_optimally(solution);
+  individual.split_cargo();
 
   //DoTwoOpt(individual, instance_.get());
   //DoMoveSearch(individual, instance_.get());
@@ -457,9 +442,8 @@ auto cye::SOTASearch::search(meta::RandomEngine &gen, cye::EVRPIndividual &&indi
     // Continue until no more improvements can be made
   }
 
-  solution.clear_patches();
-  cye::patch_cargo_optimally(solution);
-  energy_repair_->patch(solution, 151U);
+  individual.split_cargo();
+  energy_repair_->patch_routes(solution);
   // cye::patch_energy_optimal_heuristic(solution);
   individual.set_valid();
 
@@ -522,13 +506,12 @@ auto cye::SATwoOptSearch::search(meta::RandomEngine &gen, cye::EVRPIndividual &&
 
 auto cye::SwapSearch::search(meta::RandomEngine & /*gen*/, cye::EVRPIndividual &&individual) -> cye::EVRPIndividual {
   auto &solution = individual.solution();
-  solution.clear_patches();
+  individual.split_cargo();
 
-  cye::patch_cargo_optimally(solution, static_cast<unsigned>(instance_->cargo_capacity()) + 1U);
   DoSwapSearch(individual, instance_.get());
 
   // cye::patch_energy_trivially(solution);
-  energy_repair_->patch(solution, 151U);
+  energy_repair_->patch_routes(solution);
   individual.set_valid();
 
   return individual;
@@ -560,8 +543,7 @@ static auto find_route(cye::Patch<size_t> const &patch, size_t index) -> std::pa
 auto cye::HSM::mutate(meta::RandomEngine &gen, cye::EVRPIndividual &&individual) -> cye::EVRPIndividual {
   auto &solution = individual.solution();
 
-  solution.clear_patches();
-  cye::patch_cargo_optimally(solution);
+  individual.split_cargo();
 
   auto &customers = individual.genotype();
   auto distr = std::uniform_int_distribution<size_t>(0, customers.size() - 1);
@@ -588,8 +570,7 @@ auto cye::HSM::mutate(meta::RandomEngine &gen, cye::EVRPIndividual &&individual)
 auto cye::HMM::mutate(meta::RandomEngine &gen, cye::EVRPIndividual &&individual) -> cye::EVRPIndividual {
   auto &solution = individual.solution();
 
-  solution.clear_patches();
-  cye::patch_cargo_optimally(solution);
+  individual.split_cargo();
 
   auto &customers = individual.genotype();
   auto distr = std::uniform_int_distribution<size_t>(0, customers.size() - 1);
@@ -1,32 +1,125 @@
 #include "cye/repair.hpp"
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
 #include <cstddef>
-#include <deque>
+#include <functional>
 #include <limits>
 #include <print>
-#include <queue>
 #include <random>
+#include <span>
 #include <stdexcept>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 #include "cye/instance.hpp"
 #include "cye/patchable_vector.hpp"
 #include "cye/solution.hpp"
 
-struct CargoDPCell {
-  CargoDPCell() : dist(std::numeric_limits<double>::infinity()), prev(0), inserted(false) {}
+// Kernels built once per instruction set, the loader picks the widest one the CPU supports
+#if defined(__GNUC__) && defined(__x86_64__)
+#define CYE_TARGET_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define CYE_TARGET_CLONES
+#endif
+
+namespace {
+thread_local auto cargo_dp_workspace = cye::CargoDPWorkspace();
+thread_local auto split_workspace = cye::SplitWorkspace();
+thread_local auto cargo_label_workspace = cye::CargoLabelWorkspace();
+thread_local auto energy_repair_workspace = cye::EnergyRepairWorkspace();
+
+// Going straight to a node that needs energy_quant bins, bin i is reached from bin i + energy_quant of the previous
+// column. Plain lane-wise stores, so every bin is written and the loop vectorizes.
+CYE_TARGET_CLONES auto shift_bins(double const *__restrict previous_dist, double *__restrict dist,
+                                  uint32_t *__restrict prev, unsigned bin_cnt, unsigned energy_quant, double distance)
+    -> void {
+  auto reachable_cnt = energy_quant < bin_cnt ? bin_cnt - energy_quant : 0u;
+  auto shifted_dist = previous_dist + energy_quant;
+#pragma omp simd
+  for (auto i = 0UZ; i < reachable_cnt; ++i) {
+    dist[i] = shifted_dist[i] + distance;
+    prev[i] = static_cast<uint32_t>(i) + energy_quant;
+  }
+  for (auto i = reachable_cnt; i < bin_cnt; ++i) {
+    dist[i] = std::numeric_limits<double>::infinity();
+    prev[i] = 0;
+  }
+}
+
+// Builds the Pareto front reached after current_node_id from the last finished front.
+auto extend_cargo_front(cye::CargoLabelWorkspace &workspace, cye::Instance const &instance, size_t previous_node_id,
+                        size_t current_node_id) -> void {
+  using Label = cye::CargoLabelWorkspace::Label;
+
+  auto distance = instance.distance(previous_node_id, current_node_id);
+  auto distance_with_depot = instance.distance(previous_node_id, instance.depot_id()) +
+                             instance.distance(instance.depot_id(), current_node_id);
+  auto demand = instance.demand(current_node_id);
+
+  // The new front has at most one label more than the previous one, reserving up front keeps the span below valid
+  workspace.reserve(workspace.front(workspace.front_cnt() - 1).size() + 1);
+  auto previous_front = workspace.front(workspace.front_cnt() - 1);
+
+  // Going straight keeps the front sorted and non-dominated, labels without enough cargo drop out at its start
+  for (auto p = 0u; p < previous_front.size(); ++p) {
+    if (previous_front[p].cargo >= demand) {
+      workspace.push_back(Label{previous_front[p].cargo - demand, previous_front[p].dist + distance, p, false});
+    }
+  }
+
+  // The cheapest label is the first one. Refilling at the depot leaves the most cargo possible, so it only replaces
+  // the labels that are more expensive than it. On a tie going straight stays first and wins, as in the binned DP, so
+  // next to the depot no second depot is inserted.
+  auto detour = Label{instance.cargo_capacity() - demand, previous_front.front().dist + distance_with_depot, 0u, true};
+  while (!workspace.open_front().empty() && workspace.open_front().back().dist > detour.dist) {
+    workspace.pop_back();
+  }
+  if (workspace.open_front().empty() || workspace.open_front().back().cargo < detour.cargo) {
+    workspace.push_back(detour);
+  }
+  workspace.finish_front();
+}
+
+// Adds the depot visits of the cheapest label of the last front.
+auto trace_cargo_fronts(cye::Solution &solution, cye::CargoLabelWorkspace const &workspace) -> void {
+  auto &instance = solution.instance();
+
+  // The cheapest label of the last node is the first one
+  auto ind = 0u;
+
+  auto patch = cye::Patch<size_t>();
+  patch.add_change(solution.visited_node_cnt(), instance.depot_id());
+  for (auto j = solution.visited_node_cnt() + 1; j >= 1; --j) {
+    const auto &label = workspace.front(j)[ind];
+    if (label.inserted) {
+      patch.add_change(j - 1, instance.depot_id());
+    }
+    ind = label.parent;
+  }
+  patch.add_change(0, instance.depot_id());
+  patch.reverse();
+  solution.add_patch(std::move(patch));
+}
+}
 
-  double dist;
-  unsigned prev;
-  bool inserted;
-};
+auto cye::CargoDPWorkspace::reset(unsigned bin_cnt, size_t column_cnt) -> void {
+  bin_cnt_ = bin_cnt;
+  dist_.assign(bin_cnt_ * column_cnt, std::numeric_limits<double>::infinity());
+  back_.resize(bin_cnt_ * column_cnt);
+}
 
 auto cye::patch_cargo_optimally(Solution &solution, unsigned bin_cnt) -> void {
+  patch_cargo_optimally(solution, bin_cnt, cargo_dp_workspace);
+}
+
+auto cye::patch_cargo_optimally(Solution &solution, unsigned bin_cnt, CargoDPWorkspace &workspace) -> void {
   auto visited_node_cnt = solution.visited_node_cnt();
   auto &instance = solution.instance();
-  auto dp = std::vector(bin_cnt, std::vector(visited_node_cnt + 2, CargoDPCell()));
+  workspace.reset(bin_cnt, visited_node_cnt + 2);
 
   // Amount of cargo per bin
   auto cargo_quant = instance.cargo_capacity() / static_cast<double>(bin_cnt - 1);
@@ -34,15 +127,12 @@ auto cye::patch_cargo_optimally(Solution &solution, unsigned bin_cnt) -> void {
   // Forward pass
 
   // We always start at the depot with the full capacity remaining
-  dp[bin_cnt - 1][0].dist = 0;
+  workspace.column(0)[bin_cnt - 1] = 0;
 
   // Iterate over nodes in routes
   auto previous_node_id = instance.depot_id();
   auto j = 1UZ;
-  solution.base().push_back(instance.depot_id());
-  for (auto it = solution.routes().begin(); it != solution.routes().end(); ++it) {
-    auto current_node_id = *it;
-
+  auto relax = [&](size_t current_node_id) {
     // The distance between the curent ad previous node
     auto distance = instance.distance(previous_node_id, current_node_id);
     // The distance if we go from the previous node to the depo and back to the current node
@@ -52,27 +142,35 @@ auto cye::patch_cargo_optimally(Solution &solution, unsigned bin_cnt) -> void {
     auto demand = instance.demand(current_node_id);
     auto demand_quant = static_cast<unsigned>(std::ceil(demand / cargo_quant));
 
+    auto previous_column = workspace.column(j - 1);
+    auto column = workspace.column(j);
+    auto detour_bin = bin_cnt - demand_quant - 1;
+
     // For every cargo quantization
     for (auto i = 0u; i < bin_cnt; ++i) {
       // If we go from the node j-1 with capacity i to the depot and than back to the node j
-      if (dp[bin_cnt - demand_quant - 1][j].dist > dp[i][j - 1].dist + distance_with_depot) {
-        dp[bin_cnt - demand_quant - 1][j].dist = dp[i][j - 1].dist + distance_with_depot;
-        dp[bin_cnt - demand_quant - 1][j].prev = i;
-        dp[bin_cnt - demand_quant - 1][j].inserted = true;
+      if (column[detour_bin] > previous_column[i] + distance_with_depot) {
+        column[detour_bin] = previous_column[i] + distance_with_depot;
+        workspace.set_back(detour_bin, j, i, true);
       }
 
       // If we go straight from the node j-1 to j and end up with a remaining capacity i
-      if (i + demand_quant < bin_cnt && dp[i][j].dist > dp[i + demand_quant][j - 1].dist + distance) {
-        dp[i][j].dist = dp[i + demand_quant][j - 1].dist + distance;
-        dp[i][j].prev = i + demand_quant;
-        dp[i][j].inserted = false;
+      if (i + demand_quant < bin_cnt && column[i] > previous_column[i + demand_quant] + distance) {
+        column[i] = previous_column[i + demand_quant] + distance;
+        workspace.set_back(i, j, i + demand_quant, false);
       }
     }
 
     ++j;
     previous_node_id = current_node_id;
-  }
-  solution.base().pop_back();
+  };
+  solution.routes().for_each_segment([&](std::span<const size_t> segment) {
+    for (auto current_node_id : segment) {
+      relax(current_node_id);
+    }
+  });
+  // The tour ends back at the depot
+  relax(instance.depot_id());
 
   // Backward pass
 
@@ -80,8 +178,8 @@ auto cye::patch_cargo_optimally(Solution &solution, unsigned bin_cnt) -> void {
   auto ind = 0u;
   auto min_cost = std::numeric_limits<double>::infinity();
   for (auto i = 0u; i < bin_cnt; ++i) {
-    if (dp[i][visited_node_cnt + 1].dist < min_cost) {
-      min_cost = dp[i][visited_node_cnt + 1].dist;
+    if (workspace.dist(i, visited_node_cnt + 1) < min_cost) {
+      min_cost = workspace.dist(i, visited_node_cnt + 1);
       ind = i;
     }
   }
@@ -91,16 +189,76 @@ auto cye::patch_cargo_optimally(Solution &solution, unsigned bin_cnt) -> void {
   patch.add_change(solution.visited_node_cnt(), instance.depot_id());
   for (auto j = solution.visited_node_cnt() + 1; j >= 1; --j) {
     // Check if we detoured to the depot
-    if (dp[ind][j].inserted) {
+    if (workspace.inserted(ind, j)) {
       patch.add_change(j - 1, instance.depot_id());
     }
-    ind = dp[ind][j].prev;
+    ind = workspace.prev(ind, j);
   }
   patch.add_change(0, instance.depot_id());
   patch.reverse();
   solution.add_patch(std::move(patch));
 }
 
+auto cye::patch_cargo_optimally(Solution &solution) -> void {
+  patch_cargo_optimally(solution, cargo_label_workspace);
+}
+
+auto cye::patch_cargo_optimally(Solution &solution, CargoLabelWorkspace &workspace) -> void {
+  using Label = CargoLabelWorkspace::Label;
+  auto &instance = solution.instance();
+  workspace.clear();
+
+  // Forward pass
+
+  // We always start at the depot with the full capacity remaining
+  workspace.push_back(Label{instance.cargo_capacity(), 0.0, 0u, false});
+  workspace.finish_front();
+
+  auto previous_node_id = instance.depot_id();
+  solution.routes().for_each_segment([&](std::span<const size_t> segment) {
+    for (auto current_node_id : segment) {
+      extend_cargo_front(workspace, instance, previous_node_id, current_node_id);
+      previous_node_id = current_node_id;
+    }
+  });
+  // The tour ends back at the depot
+  extend_cargo_front(workspace, instance, previous_node_id, instance.depot_id());
+
+  trace_cargo_fronts(solution, workspace);
+}
+
+auto cye::patch_cargo_optimally(Solution &solution, CargoLabelWorkspace &workspace, size_t first_changed,
+                                size_t last_changed) -> void {
+  auto &instance = solution.instance();
+  const auto &routes = solution.routes();
+  auto visited_node_cnt = solution.visited_node_cnt();
+  auto front_cnt = visited_node_cnt + 2;
+  assert(workspace.front_cnt() == front_cnt);
+
+  // The tour is closed by a depot that is not part of the routes
+  auto node_id = [&](size_t p) { return p < visited_node_cnt ? routes[p] : instance.depot_id(); };
+
+  // Front j is reached after visiting the node at position j - 1, every front up to the first edit is still valid
+  if (first_changed < visited_node_cnt) {
+    workspace.retire(first_changed + 1);
+
+    for (auto j = first_changed + 1; j < front_cnt; ++j) {
+      extend_cargo_front(workspace, instance, j >= 2 ? node_id(j - 2) : instance.depot_id(), node_id(j - 1));
+
+      // Past the edit a front only depends on the one before it. Once it matches the old front up to a constant
+      // distance, so does every front after it.
+      if (j >= last_changed + 2) {
+        if (auto shift = workspace.shift_from_retired(j)) {
+          workspace.restore_retired(j + 1, *shift);
+          break;
+        }
+      }
+    }
+  }
+
+  trace_cargo_fronts(solution, workspace);
+}
+
 auto cye::patch_cargo_trivially(Solution &solution) -> void {
   auto &instance = solution.instance();
   auto cargo_capacity = instance.cargo_capacity();
@@ -126,19 +284,24 @@ auto find_charging_station(const cye::Instance &instance, size_t node1_id, size_
     -> std::optional<size_t> {
   auto best_station_id = std::optional<size_t>{};
   auto min_distance = std::numeric_limits<double>::infinity();
+  auto direct_distance = instance.distance(node1_id, node2_id);
 
-  if (node1_id != instance.depot_id() && node2_id != instance.depot_id() &&
-      remaining_battery >= instance.energy_required(node1_id, instance.depot_id())) {
-    min_distance = instance.distance(node1_id, instance.depot_id()) + instance.distance(instance.depot_id(), node2_id);
-    best_station_id = instance.depot_id();
-  }
+  // Stations come nearest first, ties are won by the depot and then by the lower id
+  for (auto station_id : instance.reachable_station_ids(node1_id)) {
+    auto distance_to_station = instance.distance(node1_id, station_id);
+
+    // The next stations are even further, neither can the vehicle reach them nor can the detour through them be
+    // shorter than twice the way there minus the direct edge
+    if (remaining_battery < instance.energy_required(node1_id, station_id)) break;
+    if (2.0 * distance_to_station - direct_distance > min_distance + 1e-9) break;
 
-  for (const auto station_id : instance.charging_station_ids()) {
-    if (station_id == node1_id || station_id == node2_id) continue;
-    if (remaining_battery < instance.energy_required(node1_id, station_id)) continue;
+    if (station_id == node2_id) continue;
+    if (station_id == instance.depot_id() && (node1_id == instance.depot_id() || node2_id == instance.depot_id())) {
+      continue;
+    }
 
-    auto distance = instance.distance(node1_id, station_id) + instance.distance(station_id, node2_id);
-    if (distance < min_distance) {
+    auto distance = distance_to_station + instance.distance(station_id, node2_id);
+    if (distance < min_distance || (distance == min_distance && station_id < *best_station_id)) {
       min_distance = distance;
       best_station_id = station_id;
     }
@@ -167,8 +330,7 @@ auto cye::patch_energy_trivially(Solution &solution) -> void {
         if (!patch.empty() && i == patch.back().ind) {
           previous_node_id = patch.back().value;
         } else {
-          auto tmp_it = it;
-          previous_node_id = *(--tmp_it);
+          previous_node_id = solution.routes()[i - 1];
         }
 
         energy += instance.energy_required(previous_node_id, current_node_id);
@@ -193,245 +355,639 @@ auto cye::patch_energy_trivially(Solution &solution) -> void {
   solution.add_patch(std::move(patch));
 }
 
-cye::OptimalEnergyRepair::OptimalEnergyRepair(std::shared_ptr<Instance> instance)
-    : instance_(instance), unvisited_queue_(cmp_) {
-  compute_cs_dist_mat_();
-}
+cye::StationNetwork::StationNetwork(std::shared_ptr<Instance> instance) : instance_(instance) {
+  static auto network_cnt = std::atomic<size_t>(0);
+  id_ = network_cnt.fetch_add(1, std::memory_order_relaxed);
 
-auto cye::OptimalEnergyRepair::compute_cs_dist_mat_() -> void {
   auto cs_cnt = instance_->charging_station_cnt() + 1;
+  auto cs_node_id = [&](size_t i) { return i == 0 ? instance_->depot_id() : instance_->charging_station_ids()[i - 1]; };
   cs_dist_mat_ = std::vector(cs_cnt, std::vector(cs_cnt, std::numeric_limits<double>::infinity()));
+  cs_next_hop_ = std::vector(cs_cnt, std::vector(cs_cnt, std::numeric_limits<uint16_t>::max()));
 
+  // Two stations are connected if a full battery gets the vehicle from one to the other
   for (auto i = 0UZ; i < cs_cnt; ++i) {
-    cs_dist_mat_[i][i] = 0.f;
-    auto start_node_id = i == 0 ? instance_->depot_id() : instance_->charging_station_ids()[i - 1];
-    for (auto j = i + 1; j < cs_cnt; ++j) {
-      auto goal_node_id = j == 0 ? instance_->depot_id() : instance_->charging_station_ids()[j - 1];
-      auto ret = find_between_(start_node_id, goal_node_id);
-      if (ret) {
-        cs_dist_mat_[i][j] = ret->second;
-        cs_dist_mat_[j][i] = ret->second;
+    for (auto j = 0UZ; j < cs_cnt; ++j) {
+      if (i == j || instance_->energy_required(cs_node_id(i), cs_node_id(j)) <= instance_->battery_capacity()) {
+        cs_dist_mat_[i][j] = i == j ? 0.0 : instance_->distance(cs_node_id(i), cs_node_id(j));
+        cs_next_hop_[i][j] = static_cast<uint16_t>(j);
       }
     }
   }
-}
 
-auto cye::OptimalEnergyRepair::reset_() -> void {
-  visited_.clear();
-  while (!unvisited_queue_.empty()) {
-    unvisited_queue_.pop();
+  // Floyd-Warshall, remembering the first station after i on the way to j
+  for (auto k = 0UZ; k < cs_cnt; ++k) {
+    for (auto i = 0UZ; i < cs_cnt; ++i) {
+      for (auto j = 0UZ; j < cs_cnt; ++j) {
+        if (cs_dist_mat_[i][k] + cs_dist_mat_[k][j] < cs_dist_mat_[i][j]) {
+          cs_dist_mat_[i][j] = cs_dist_mat_[i][k] + cs_dist_mat_[k][j];
+          cs_next_hop_[i][j] = cs_next_hop_[i][k];
+        }
+      }
+    }
   }
 }
 
-auto cye::OptimalEnergyRepair::find_between_(size_t start_node_id, size_t goal_node_id)
-    -> std::optional<std::pair<std::vector<size_t>, double>> {
-  reset_();
+auto cye::StationNetwork::station_pairs(size_t previous_node_id, size_t current_node_id) const
+    -> std::vector<StationPair> {
+  auto pairs = std::vector<StationPair>();
+  auto battery_capacity = instance_->battery_capacity();
+  auto cs_cnt = instance_->charging_station_cnt() + 1;
+  auto candidates = std::vector<StationPair>();
 
-  unvisited_queue_.emplace(start_node_id, start_node_id, 0.f, instance_->distance(start_node_id, goal_node_id));
+  for (auto l = 0UZ; l < cs_cnt; ++l) {
+    auto exit_node_id = l == 0 ? instance_->depot_id() : instance_->charging_station_ids()[l - 1];
+    auto energy_from_exit_cs = instance_->energy_required(exit_node_id, current_node_id);
 
-  while (!unvisited_queue_.empty()) {
-    auto unvisited_node = unvisited_queue_.top();
-    unvisited_queue_.pop();
+    // Not really necessary, but it keeps the detours short
+    if (instance_->is_charging_station(current_node_id) && exit_node_id != current_node_id) continue;
+    if (energy_from_exit_cs > battery_capacity) continue;
 
-    if (visited_.contains(unvisited_node.node_id)) {
-      continue;
-    }
+    candidates.clear();
+    for (auto k = 0UZ; k < cs_cnt; ++k) {
+      auto entry_node_id = k == 0 ? instance_->depot_id() : instance_->charging_station_ids()[k - 1];
+      auto energy_to_entry_cs = instance_->energy_required(previous_node_id, entry_node_id);
 
-    visited_.emplace(unvisited_node.node_id, VisitedNode_{unvisited_node.g, unvisited_node.parent});
+      if (entry_node_id == previous_node_id || energy_to_entry_cs > battery_capacity ||
+          cs_dist_mat_[k][l] == std::numeric_limits<double>::infinity()) {
+        continue;
+      }
 
-    if (unvisited_node.node_id == goal_node_id) {
-      break;
+      auto dist = instance_->distance(previous_node_id, entry_node_id) + cs_dist_mat_[k][l] +
+                  instance_->distance(exit_node_id, current_node_id);
+      candidates.push_back(StationPair{energy_to_entry_cs, energy_from_exit_cs, dist, static_cast<uint16_t>(k),
+                                       static_cast<uint16_t>(l)});
     }
 
-    for (auto cs_id : instance_->charging_station_ids()) {
-      if (visited_.contains(cs_id)) {
-        continue;
+    // Through the same exit, an entry is only worth it if no entry that is cheaper to reach is also shorter
+    std::ranges::sort(candidates, [](StationPair const &a, StationPair const &b) {
+      return a.energy_to_entry < b.energy_to_entry || (a.energy_to_entry == b.energy_to_entry && a.dist < b.dist);
+    });
+    auto min_dist = std::numeric_limits<double>::infinity();
+    for (auto const &candidate : candidates) {
+      if (candidate.dist < min_dist) {
+        pairs.push_back(candidate);
+        min_dist = candidate.dist;
       }
+    }
+  }
 
-      if (instance_->energy_required(unvisited_node.node_id, cs_id) <= instance_->battery_capacity()) {
-        unvisited_queue_.emplace(cs_id, unvisited_node.node_id,
-                                 unvisited_node.g + instance_->distance(unvisited_node.node_id, cs_id),
-                                 instance_->distance(cs_id, goal_node_id));
-      }
+  // Across exits, drop every pair another one beats in energy to the entry, energy from the exit and distance
+  std::ranges::sort(pairs, {}, &StationPair::energy_from_exit);
+  auto kept = 0UZ;
+  for (auto i = 0UZ; i < pairs.size(); ++i) {
+    auto dominated = false;
+    for (auto j = 0UZ; j < kept && !dominated; ++j) {
+      dominated = pairs[j].energy_to_entry <= pairs[i].energy_to_entry && pairs[j].dist <= pairs[i].dist;
+    }
+    if (!dominated) {
+      pairs[kept++] = pairs[i];
     }
+  }
+  pairs.resize(kept);
 
-    if (!visited_.contains(instance_->depot_id())) {
-      if (instance_->energy_required(unvisited_node.node_id, instance_->depot_id()) <= instance_->battery_capacity()) {
-        unvisited_queue_.emplace(instance_->depot_id(), unvisited_node.node_id,
-                                 unvisited_node.g + instance_->distance(unvisited_node.node_id, instance_->depot_id()),
-                                 instance_->distance(instance_->depot_id(), goal_node_id));
-      }
+  // The DP tries the pairs in order of the energy they need and stops at the first it cannot afford
+  std::ranges::sort(pairs, {}, &StationPair::energy_to_entry);
+
+  return pairs;
+}
+
+auto cye::StationNetwork::add_charging_detour(Patch<size_t> &patch, size_t j, uint16_t entry_ind,
+                                              uint16_t exit_ind) const -> void {
+  auto entry_node_id = entry_ind == 0 ? instance_->depot_id() : instance_->charging_station_ids()[entry_ind - 1];
+  auto exit_node_id = exit_ind == 0 ? instance_->depot_id() : instance_->charging_station_ids()[exit_ind - 1];
+
+  // The patch is reversed once the whole route is traced, so the detour is added back to front
+  if (entry_node_id == exit_node_id) {
+    patch.add_change(j, entry_node_id);
+  } else {
+    patch.add_change(j, exit_node_id);
+
+    for (auto k = cs_next_hop_[exit_ind][entry_ind]; k != entry_ind; k = cs_next_hop_[k][entry_ind]) {
+      patch.add_change(j, k == 0 ? instance_->depot_id() : instance_->charging_station_ids()[k - 1]);
     }
+
+    patch.add_change(j, entry_node_id);
   }
+}
 
-  if (!visited_.contains(goal_node_id)) {
-    return {};
+auto cye::EnergyRepairWorkspace::station_pairs_(StationNetwork const &network, size_t previous_node_id,
+                                                size_t current_node_id)
+    -> std::span<const StationNetwork::StationPair> {
+  // The pairs belong to one network, a workspace that moves on to another one starts over
+  if (network_id_ != network.id()) {
+    station_pairs_cache_.clear();
+    network_id_ = network.id();
   }
 
-  auto ret = std::vector<size_t>();
-  for (auto node_id = visited_[goal_node_id].parent; node_id != start_node_id; node_id = visited_[node_id].parent) {
-    ret.push_back(node_id);
+  auto [it, inserted] =
+      station_pairs_cache_.try_emplace(previous_node_id * network.instance().node_cnt() + current_node_id);
+  if (inserted) {
+    it->second = network.station_pairs(previous_node_id, current_node_id);
   }
 
-  return {{ret, visited_[goal_node_id].g}};
+  return it->second;
 }
 
-auto cye::OptimalEnergyRepair::fill_dp(Solution &solution, unsigned bin_cnt) -> std::vector<std::vector<DPCell>> {
-  auto visited_node_cnt = solution.visited_node_cnt();
-  auto &instance = solution.instance();
+cye::OptimalEnergyRepair::OptimalEnergyRepair(std::shared_ptr<Instance> instance,
+                                              std::shared_ptr<RouteCache> route_cache)
+    : OptimalEnergyRepair(std::make_shared<const StationNetwork>(instance), route_cache) {}
+
+cye::OptimalEnergyRepair::OptimalEnergyRepair(std::shared_ptr<const StationNetwork> network,
+                                              std::shared_ptr<RouteCache> route_cache)
+    : network_(network),
+      instance_(network->instance_ptr()),
+      route_cache_(route_cache ? route_cache : std::make_shared<RouteCache>()) {}
+
+auto cye::OptimalEnergyRepair::DPTable_::resize(size_t column_cnt, unsigned bin_cnt) -> void {
+  dist.assign(column_cnt * bin_cnt, std::numeric_limits<double>::infinity());
+  prev.assign(column_cnt * bin_cnt, 0);
+  entry_ind.assign(column_cnt * bin_cnt, std::numeric_limits<uint16_t>::max());
+  exit_ind.assign(column_cnt * bin_cnt, std::numeric_limits<uint16_t>::max());
+}
 
+auto cye::OptimalEnergyRepair::relax_(EnergyRepairWorkspace &workspace, size_t previous_node_id,
+                                      size_t current_node_id, unsigned bin_cnt, DPTable_ &table,
+                                      size_t current_column) const -> void {
   auto no_cs = std::numeric_limits<uint16_t>::max();
-  auto dp = std::vector(bin_cnt, std::vector(visited_node_cnt, DPCell()));
+  auto previous_dist = table.dist.data() + (current_column - 1) * bin_cnt;
+  auto offset = static_cast<std::ptrdiff_t>(current_column * bin_cnt);
+  auto dist = table.dist.data() + offset;
+  auto prev = table.prev.data() + offset;
 
   // Energy per bin
-  auto energy_per_bin = instance.battery_capacity() / static_cast<double>(bin_cnt - 1);
-  auto cs_cnt = instance_->charging_station_cnt() + 1;
+  auto energy_per_bin = instance_->battery_capacity() / static_cast<double>(bin_cnt - 1);
+  auto pairs = workspace.station_pairs_(*network_, previous_node_id, current_node_id);
+  auto &suffix_dist = workspace.suffix_dist_;
+  auto &suffix_bin = workspace.suffix_bin_;
+
+  // Any bin with at least as much energy will do as a start, so each target only needs the best bin from some bin up
+  suffix_dist.resize(bin_cnt);
+  suffix_bin.resize(bin_cnt);
+  suffix_dist[bin_cnt - 1] = previous_dist[bin_cnt - 1];
+  suffix_bin[bin_cnt - 1] = bin_cnt - 1;
+  for (auto i = bin_cnt - 1; i-- > 0;) {
+    auto better = previous_dist[i] <= suffix_dist[i + 1];
+    suffix_dist[i] = better ? previous_dist[i] : suffix_dist[i + 1];
+    suffix_bin[i] = better ? i : suffix_bin[i + 1];
+  }
 
-  // Forward pass
+  // The distance between the curent and the previous node
+  auto distance = instance_->distance(previous_node_id, current_node_id);
+  auto energy = distance * instance_->energy_consumption();
+  auto energy_quant = static_cast<unsigned>(std::ceil(energy / energy_per_bin));
+
+  // If we go straight from the node j-1 to j, a charging station fills the battery
+  std::fill_n(table.entry_ind.begin() + offset, bin_cnt, no_cs);
+  std::fill_n(table.exit_ind.begin() + offset, bin_cnt, no_cs);
+  if (instance_->is_charging_station(current_node_id)) {
+    std::fill_n(dist, bin_cnt, std::numeric_limits<double>::infinity());
+    std::fill_n(prev, bin_cnt, 0u);
+    if (energy_quant < bin_cnt) {
+      dist[bin_cnt - 1] = suffix_dist[energy_quant] + distance;
+      prev[bin_cnt - 1] = suffix_bin[energy_quant];
+    }
+  } else {
+    shift_bins(previous_dist, dist, prev, bin_cnt, energy_quant, distance);
+  }
+
+  // If we charge the vehicle between nodes j-1 and j, starting from the first bin that reaches the entry
+  for (auto const &pair : pairs) {
+    auto first_bin = static_cast<unsigned>(std::ceil(pair.energy_to_entry / energy_per_bin));
+    while (first_bin > 0 && static_cast<double>(first_bin - 1) * energy_per_bin >= pair.energy_to_entry) --first_bin;
+    while (first_bin < bin_cnt && static_cast<double>(first_bin) * energy_per_bin < pair.energy_to_entry) ++first_bin;
+    if (first_bin >= bin_cnt) break;
+
+    auto energy_from_exit_cs_quant = static_cast<unsigned>(std::ceil(pair.energy_from_exit / energy_per_bin));
+    if (energy_from_exit_cs_quant >= bin_cnt) continue;
+
+    auto target = bin_cnt - energy_from_exit_cs_quant - 1;
+    if (dist[target] > suffix_dist[first_bin] + pair.dist) {
+      dist[target] = suffix_dist[first_bin] + pair.dist;
+      prev[target] = suffix_bin[first_bin];
+      table.entry_ind[offset + target] = pair.entry_ind;
+      table.exit_ind[offset + target] = pair.exit_ind;
+    }
+  }
+}
+
+auto cye::OptimalEnergyRepair::fill_dp(Solution &solution, unsigned bin_cnt) const
+    -> std::vector<std::vector<DPCell>> {
+  auto node_ids = std::vector<size_t>();
+  node_ids.reserve(solution.visited_node_cnt());
+  solution.routes().for_each_segment(
+      [&](std::span<const size_t> segment) { node_ids.insert(node_ids.end(), segment.begin(), segment.end()); });
+
+  auto table = DPTable_();
+  table.resize(node_ids.size(), bin_cnt);
 
   // We always start at the depot with a full battery
-  dp[bin_cnt - 1][0].dist = 0.f;
+  table.dist[bin_cnt - 1] = 0.0;
 
-  // Iterate over nodes in routes
-  auto previous_node_id = *solution.routes().begin();
-  auto j = 1UZ;
-  for (auto it = ++solution.routes().begin(); it != solution.routes().end(); ++it) {
-    auto current_node_id = *it;
-    // For every energy quantization
+  for (auto j = 1UZ; j < node_ids.size(); ++j) {
+    relax_(energy_repair_workspace, node_ids[j - 1], node_ids[j], bin_cnt, table, j);
+  }
+
+  auto dp = std::vector(bin_cnt, std::vector(node_ids.size(), DPCell()));
+  for (auto j = 0UZ; j < node_ids.size(); ++j) {
     for (auto i = 0u; i < bin_cnt; ++i) {
-      // If we charge the vehicle between nodes j-1 and j
-      for (auto k = 0UZ; k < cs_cnt; ++k) {
-        auto entry_node_id = k == 0 ? instance_->depot_id() : instance_->charging_station_ids()[k - 1];
+      auto &cell = dp[i][j];
+      cell.dist = table.dist[j * bin_cnt + i];
+      cell.prev = table.prev[j * bin_cnt + i];
+      cell.entry_ind = table.entry_ind[j * bin_cnt + i];
+      cell.exit_ind = table.exit_ind[j * bin_cnt + i];
+    }
+  }
 
-        if (entry_node_id == previous_node_id) {
-          continue;
-        }
+  return dp;
+}
 
-        auto distance_to_entry_cs = instance_->distance(previous_node_id, entry_node_id);
-        auto energy_to_entry_cs = distance_to_entry_cs * instance.energy_consumption();
-        auto remaining_battery = static_cast<double>(i) * energy_per_bin;
+auto cye::OptimalEnergyRepair::checkpoint_interval_(size_t column_cnt, unsigned bin_cnt, size_t memory_budget)
+    -> size_t {
+  auto memory = [&](size_t interval) {
+    auto segment_cnt = (column_cnt - 1 + interval - 1) / interval;
+    // At worst no bin is pruned
+    return (segment_cnt + interval + 1) * bin_cnt * sizeof(EnergyRepairWorkspace::BinLabel_);
+  };
 
-        if (energy_to_entry_cs > remaining_battery) {
-          continue;
-        }
+  // Keep as few checkpoints as the budget allows, every segment gets recomputed once regardless of its length
+  auto best_interval = std::max(column_cnt - 1, 1UZ);
+  for (auto interval = best_interval; interval >= 1; --interval) {
+    if (memory(interval) <= memory_budget) return interval;
+    if (memory(interval) < memory(best_interval)) best_interval = interval;
+  }
 
-        for (auto l = 0UZ; l < cs_cnt; ++l) {
-          auto exit_node_id = l == 0 ? instance_->depot_id() : instance_->charging_station_ids()[l - 1];
-
-          // Not really necessary, but it cleans up the table
-          if (instance.is_charging_station(current_node_id) && exit_node_id != current_node_id) {
-            continue;
-          }
-
-          auto distance_from_exit_cs = instance_->distance(exit_node_id, current_node_id);
-          auto energy_from_exit_cs = distance_from_exit_cs * instance_->energy_consumption();
-          auto energy_from_exit_cs_quant = static_cast<unsigned>(std::ceil(energy_from_exit_cs / energy_per_bin));
-          auto total_distance = distance_to_entry_cs + cs_dist_mat_[k][l] + distance_from_exit_cs;
-
-          if (energy_from_exit_cs_quant < bin_cnt &&
-              dp[bin_cnt - energy_from_exit_cs_quant - 1][j].dist > dp[i][j - 1].dist + total_distance) {
-            dp[bin_cnt - energy_from_exit_cs_quant - 1][j].dist = dp[i][j - 1].dist + total_distance;
-            dp[bin_cnt - energy_from_exit_cs_quant - 1][j].prev = i;
-            dp[bin_cnt - energy_from_exit_cs_quant - 1][j].entry_ind = k;
-            dp[bin_cnt - energy_from_exit_cs_quant - 1][j].exit_ind = l;
-          }
-        }
-      }
+  return best_interval;
+}
+
+auto cye::OptimalEnergyRepair::extend_bin_front_(EnergyRepairWorkspace &workspace, size_t previous_node_id,
+                                                 size_t current_node_id, unsigned bin_cnt) const -> void {
+  using BinLabel = EnergyRepairWorkspace::BinLabel_;
+  auto no_cs = std::numeric_limits<uint16_t>::max();
+  auto &labels = workspace.bin_labels_;
+  auto &offsets = workspace.bin_offsets_;
+  auto &candidates = workspace.bin_candidates_;
+
+  auto first = offsets[offsets.size() - 2];
+  auto previous = std::span<const BinLabel>(labels.data() + first, labels.size() - first);
+
+  // No bin is beaten by a higher one, so the first bin from some bin up is the cheapest one from there
+  auto cheapest_from = [&](unsigned bin) { return std::ranges::lower_bound(previous, bin, {}, &BinLabel::bin); };
+
+  // Energy per bin
+  auto energy_per_bin = instance_->battery_capacity() / static_cast<double>(bin_cnt - 1);
+
+  // The distance between the curent and the previous node
+  auto distance = instance_->distance(previous_node_id, current_node_id);
+  auto energy = distance * instance_->energy_consumption();
+  auto energy_quant = static_cast<unsigned>(std::ceil(energy / energy_per_bin));
+
+  candidates.clear();
+
+  // If we go straight from the previous node, a charging station fills the battery
+  if (instance_->is_charging_station(current_node_id)) {
+    auto it = cheapest_from(energy_quant);
+    if (it != previous.end()) {
+      candidates.push_back(BinLabel{it->dist + distance, bin_cnt - 1, it->bin, no_cs, no_cs});
+    }
+  } else {
+    for (auto it = cheapest_from(energy_quant); it != previous.end(); ++it) {
+      candidates.push_back(BinLabel{it->dist + distance, it->bin - energy_quant, it->bin, no_cs, no_cs});
+    }
+  }
+
+  // If we charge the vehicle between the previous and the current node, starting from the first bin that reaches the
+  // entry
+  for (auto const &pair : workspace.station_pairs_(*network_, previous_node_id, current_node_id)) {
+    auto first_bin = static_cast<unsigned>(std::ceil(pair.energy_to_entry / energy_per_bin));
+    while (first_bin > 0 && static_cast<double>(first_bin - 1) * energy_per_bin >= pair.energy_to_entry) --first_bin;
+    while (first_bin < bin_cnt && static_cast<double>(first_bin) * energy_per_bin < pair.energy_to_entry) ++first_bin;
+
+    // The pairs need more and more energy, once no bin reaches an entry none reaches the next ones
+    auto it = cheapest_from(first_bin);
+    if (it == previous.end()) break;
+
+    auto energy_from_exit_cs_quant = static_cast<unsigned>(std::ceil(pair.energy_from_exit / energy_per_bin));
+    if (energy_from_exit_cs_quant >= bin_cnt) continue;
+
+    candidates.push_back(BinLabel{it->dist + pair.dist, bin_cnt - energy_from_exit_cs_quant - 1, it->bin,
+                                  pair.entry_ind, pair.exit_ind});
+  }
+
+  // Every bin takes its first cheapest candidate, like the full table where going straight is tried first and a
+  // detour has to be strictly shorter. A bin is kept unless a higher one is strictly shorter.
+  std::ranges::stable_sort(candidates, std::ranges::greater(), &BinLabel::bin);
+
+  auto front_begin = labels.size();
+  auto min_dist = std::numeric_limits<double>::infinity();
+  for (auto i = 0UZ; i < candidates.size();) {
+    auto best = i;
+    auto j = i + 1;
+    for (; j < candidates.size() && candidates[j].bin == candidates[i].bin; ++j) {
+      if (candidates[j].dist < candidates[best].dist) best = j;
+    }
+
+    if (candidates[best].dist <= min_dist) {
+      labels.push_back(candidates[best]);
+      min_dist = candidates[best].dist;
+    }
+    i = j;
+  }
+  std::reverse(labels.begin() + static_cast<std::ptrdiff_t>(front_begin), labels.end());
+  offsets.push_back(labels.size());
+}
+
+auto cye::OptimalEnergyRepair::patch(Solution &solution, unsigned bin_cnt, size_t memory_budget) const -> void {
+  using BinLabel = EnergyRepairWorkspace::BinLabel_;
+  auto no_cs = std::numeric_limits<uint16_t>::max();
+  auto &workspace = energy_repair_workspace;
+  auto &labels = workspace.bin_labels_;
+  auto &offsets = workspace.bin_offsets_;
+
+  gather_node_ids_(solution, workspace.node_ids_);
+  auto const &node_ids = workspace.node_ids_;
+  auto column_cnt = node_ids.size();
+
+  // Only every interval-th column is kept, the columns in between are recomputed from them one segment at a time.
+  // If the whole table fits the budget there is a single segment and nothing is recomputed.
+  auto interval = checkpoint_interval_(column_cnt, bin_cnt, memory_budget);
+  auto segment_cnt = std::max((column_cnt - 1 + interval - 1) / interval, 1UZ);
+  auto checkpoints = std::vector<std::vector<BinLabel>>(segment_cnt);
+
+  auto column = [&](size_t j) {
+    return std::span<const BinLabel>(labels.data() + offsets[j], offsets[j + 1] - offsets[j]);
+  };
+
+  // Fills the columns of segment s and returns the index of its last column
+  auto fill_segment = [&](size_t s) {
+    auto first = s * interval;
+    auto last = std::min(first + interval, column_cnt - 1);
+
+    labels.assign(checkpoints[s].begin(), checkpoints[s].end());
+    offsets.assign({0UZ, labels.size()});
+    for (auto j = first + 1; j <= last; ++j) {
+      extend_bin_front_(workspace, node_ids[j - 1], node_ids[j], bin_cnt);
+    }
+
+    return last;
+  };
+
+  // Forward pass
+
+  // We always start at the depot with a full battery
+  checkpoints[0].push_back(BinLabel{0.0, bin_cnt - 1, 0u, no_cs, no_cs});
+
+  for (auto s = 0UZ; s + 1 < segment_cnt; ++s) {
+    auto last = fill_segment(s);
+    auto last_column = column(last - s * interval);
+    checkpoints[s + 1].assign(last_column.begin(), last_column.end());
+  }
+  auto last = fill_segment(segment_cnt - 1);
+
+  // Backward pass
 
-      // The distance between the curent and the previous node
-      auto distance = instance.distance(previous_node_id, current_node_id);
-      auto energy = distance * instance.energy_consumption();
-      auto energy_quant = static_cast<unsigned>(std::ceil(energy / energy_per_bin));
-
-      // If we go straight from the node j-1 to j and end up with a remaining battery i
-      auto bin_after = instance.is_charging_station(current_node_id) ? bin_cnt - 1 : i;
-      if (i + energy_quant < bin_cnt && dp[bin_after][j].dist > dp[i + energy_quant][j - 1].dist + distance) {
-        dp[bin_after][j].dist = dp[i + energy_quant][j - 1].dist + distance;
-        dp[bin_after][j].prev = i + energy_quant;
-        dp[bin_after][j].entry_ind = no_cs;
-        dp[bin_after][j].exit_ind = no_cs;
+  // The cheapest bin of the last column is its lowest one
+  auto last_column = column(last - (segment_cnt - 1) * interval);
+  if (last_column.empty()) {
+    throw std::runtime_error("Solution not found");
+  }
+
+  // Trace back through the table, one segment at a time
+  auto bin = last_column.front().bin;
+  auto patch = Patch<size_t>();
+  for (auto s = segment_cnt; s-- > 0;) {
+    auto first = s * interval;
+    if (s + 1 < segment_cnt) {
+      last = fill_segment(s);
+    }
+
+    for (auto j = last; j > first; --j) {
+      auto const &label = *std::ranges::lower_bound(column(j - first), bin, {}, &BinLabel::bin);
+      if (label.entry_ind != no_cs) {
+        network_->add_charging_detour(patch, j, label.entry_ind, label.exit_ind);
       }
+
+      bin = label.prev;
     }
+  }
 
-    previous_node_id = current_node_id;
-    ++j;
+  patch.reverse();
+  solution.add_patch(std::move(patch));
+}
+
+auto cye::OptimalEnergyRepair::extend_front_(EnergyRepairWorkspace &workspace, size_t previous_node_id,
+                                             size_t current_node_id) const -> void {
+  using EnergyLabel = EnergyRepairWorkspace::EnergyLabel_;
+  auto &labels = workspace.labels_;
+  auto &offsets = workspace.offsets_;
+  auto &candidates = workspace.candidates_;
+  auto no_cs = std::numeric_limits<uint16_t>::max();
+  auto battery_capacity = instance_->battery_capacity();
+  auto is_charging_station = instance_->is_charging_station(current_node_id);
+
+  auto first = offsets[offsets.size() - 2];
+  auto previous = std::span<const EnergyLabel>(labels.data() + first, labels.size() - first);
+
+  // The front is sorted by remaining energy and distance alike, so the first label that can drive a leg is the
+  // cheapest one that can
+  auto cheapest_with = [&](double energy) {
+    return static_cast<uint32_t>(std::ranges::lower_bound(previous, energy, {}, &EnergyLabel::energy) -
+                                 previous.begin());
+  };
+
+  candidates.clear();
+
+  // If we go straight from the previous node
+  auto distance = instance_->distance(previous_node_id, current_node_id);
+  auto energy_required = instance_->energy_required(previous_node_id, current_node_id);
+  for (auto p = cheapest_with(energy_required); p < previous.size(); ++p) {
+    auto energy = is_charging_station ? battery_capacity : previous[p].energy - energy_required;
+    candidates.push_back(EnergyLabel{energy, previous[p].dist + distance, p, no_cs, no_cs});
+
+    // A charging station fills every label up, only the cheapest one is worth keeping
+    if (is_charging_station) break;
   }
 
-  return dp;
+  // If we charge the vehicle between the previous and the current node, leaving the last station with a full battery
+  for (auto const &pair : workspace.station_pairs_(*network_, previous_node_id, current_node_id)) {
+    auto p = cheapest_with(pair.energy_to_entry);
+    if (p == previous.size()) break;
+
+    candidates.push_back(EnergyLabel{battery_capacity - pair.energy_from_exit, previous[p].dist + pair.dist, p,
+                                     pair.entry_ind, pair.exit_ind});
+  }
+
+  // Keep only the labels no other label beats in both energy and distance, going straight wins ties
+  std::ranges::stable_sort(candidates, [](EnergyLabel const &a, EnergyLabel const &b) {
+    return a.energy > b.energy || (a.energy == b.energy && a.dist < b.dist);
+  });
+
+  auto front_begin = labels.size();
+  auto min_dist = std::numeric_limits<double>::infinity();
+  for (auto const &candidate : candidates) {
+    if (candidate.dist < min_dist) {
+      labels.push_back(candidate);
+      min_dist = candidate.dist;
+    }
+  }
+  std::reverse(labels.begin() + static_cast<std::ptrdiff_t>(front_begin), labels.end());
+  offsets.push_back(labels.size());
 }
 
-auto cye::OptimalEnergyRepair::patch(Solution &solution, unsigned bin_cnt) -> void {
-  auto dp = fill_dp(solution, bin_cnt);
-  auto visited_node_cnt = solution.visited_node_cnt();
+auto cye::OptimalEnergyRepair::solve_labels_(EnergyRepairWorkspace &workspace, std::span<const size_t> node_ids,
+                                             std::vector<ChargingDetour> &detours) const -> double {
+  using EnergyLabel = EnergyRepairWorkspace::EnergyLabel_;
   auto no_cs = std::numeric_limits<uint16_t>::max();
+  auto &labels = workspace.labels_;
+  auto &offsets = workspace.offsets_;
+  labels.clear();
+  offsets.assign(1, 0UZ);
+
+  // Forward pass
+
+  // We always start at the depot with a full battery
+  labels.push_back(EnergyLabel{instance_->battery_capacity(), 0.0, 0u, no_cs, no_cs});
+  offsets.push_back(labels.size());
+
+  for (auto j = 1UZ; j < node_ids.size(); ++j) {
+    extend_front_(workspace, node_ids[j - 1], node_ids[j]);
+  }
 
   // Backward pass
 
-  // Find the smallest cost in the last column
+  // The cheapest label of the last node is the first one
+  if (offsets[offsets.size() - 2] == labels.size()) {
+    throw std::runtime_error("Solution not found");
+  }
+
+  // Trace back through the fronts
   auto ind = 0u;
-  auto min_cost = std::numeric_limits<double>::infinity();
-  for (auto i = 0u; i < bin_cnt; ++i) {
-    if (dp[i][visited_node_cnt - 1].dist < min_cost) {
-      min_cost = dp[i][visited_node_cnt - 1].dist;
-      ind = i;
+  for (auto j = node_ids.size() - 1; j >= 1; --j) {
+    auto const &label = labels[offsets[j] + ind];
+    if (label.entry_ind != no_cs) {
+      detours.push_back(ChargingDetour{j, label.entry_ind, label.exit_ind});
     }
+
+    ind = label.parent;
   }
 
-  if (min_cost == std::numeric_limits<double>::infinity()) {
-    throw std::runtime_error("Solution not found");
+  return labels[offsets[offsets.size() - 2]].dist;
+}
+
+auto cye::OptimalEnergyRepair::gather_node_ids_(Solution const &solution, std::vector<size_t> &node_ids) -> void {
+  node_ids.clear();
+  node_ids.reserve(solution.visited_node_cnt());
+  solution.routes().for_each_segment(
+      [&](std::span<const size_t> segment) { node_ids.insert(node_ids.end(), segment.begin(), segment.end()); });
+}
+
+auto cye::OptimalEnergyRepair::distance_without_detours_(std::span<const size_t> route) const -> double {
+  auto battery_capacity = instance_->battery_capacity();
+  auto energy = battery_capacity;
+  auto distance = 0.0;
+  for (auto j = 1UZ; j < route.size(); ++j) {
+    energy -= instance_->energy_required(route[j - 1], route[j]);
+    if (energy < 0.0) return std::numeric_limits<double>::infinity();
+
+    distance += instance_->distance(route[j - 1], route[j]);
+    if (instance_->is_charging_station(route[j])) energy = battery_capacity;
   }
 
-  // Trace back through the table
+  return distance;
+}
+
+auto cye::OptimalEnergyRepair::patch(Solution &solution) const -> void { patch(solution, energy_repair_workspace); }
+
+auto cye::OptimalEnergyRepair::patch(Solution &solution, EnergyRepairWorkspace &workspace) const -> void {
+  gather_node_ids_(solution, workspace.node_ids_);
+  workspace.detours_.clear();
+  solve_labels_(workspace, workspace.node_ids_, workspace.detours_);
+
   auto patch = Patch<size_t>();
-  for (auto j = solution.visited_node_cnt() - 1; j >= 1; --j) {
-    if (dp[ind][j].entry_ind != no_cs) {
-      auto entry_node_id = dp[ind][j].entry_ind == 0 ? instance_->depot_id()
-                                                     : instance_->charging_station_ids()[dp[ind][j].entry_ind - 1];
-      auto exit_node_id =
-          dp[ind][j].exit_ind == 0 ? instance_->depot_id() : instance_->charging_station_ids()[dp[ind][j].exit_ind - 1];
-
-      if (entry_node_id == exit_node_id) {
-        patch.add_change(j, entry_node_id);
-      } else {
-        patch.add_change(j, exit_node_id);
+  for (auto const &detour : workspace.detours_) {
+    network_->add_charging_detour(patch, detour.position, detour.entry_ind, detour.exit_ind);
+  }
 
-        auto [cs_ids, _] = *find_between_(entry_node_id, exit_node_id);
-        for (auto cs_id : cs_ids) {
-          patch.add_change(j, cs_id);
-        }
+  patch.reverse();
+  solution.add_patch(std::move(patch));
+}
 
-        patch.add_change(j, entry_node_id);
-      }
+auto cye::OptimalEnergyRepair::patch_routes(Solution &solution) const -> double {
+  return patch_routes(solution, energy_repair_workspace);
+}
+
+auto cye::OptimalEnergyRepair::patch_routes(Solution &solution, EnergyRepairWorkspace &workspace) const -> double {
+  auto &node_ids = workspace.node_ids_;
+  auto &detours = workspace.detours_;
+  gather_node_ids_(solution, node_ids);
+  assert(node_ids.front() == instance_->depot_id() && node_ids.back() == instance_->depot_id());
+
+  // Routes are visited back to front, so the detours come in the order the traceback of patch would add them
+  auto patch = Patch<size_t>();
+  auto cost = 0.0;
+  auto last = node_ids.size() - 1;
+  for (auto first = last; first-- > 0;) {
+    if (node_ids[first] != instance_->depot_id()) continue;
+
+    auto route = std::span<const size_t>(node_ids.data() + first, last - first + 1);
+
+    // No detour makes a route shorter, so one that can be driven as it is needs neither the DP nor the cache
+    auto distance = distance_without_detours_(route);
+    if (distance != std::numeric_limits<double>::infinity()) {
+      cost += distance;
+      last = first;
+      continue;
     }
 
-    ind = dp[ind][j].prev;
+    auto hash = RouteCache::hash(network_->id(), route);
+    auto route_cost = 0.0;
+    if (!route_cache_->find(network_->id(), hash, route, detours, route_cost)) {
+      detours.clear();
+      route_cost = solve_labels_(workspace, route, detours);
+      route_cache_->insert(network_->id(), hash, route, detours, route_cost);
+    }
+
+    for (auto const &detour : detours) {
+      network_->add_charging_detour(patch, first + detour.position, detour.entry_ind, detour.exit_ind);
+    }
+    cost += route_cost;
+    last = first;
   }
 
   patch.reverse();
   solution.add_patch(std::move(patch));
+
+  return cost;
 }
 
-auto cye::linear_split(Solution &solution) -> void {
+auto cye::linear_split(Solution &solution) -> void { linear_split(solution, split_workspace); }
+
+auto cye::linear_split(Solution &solution, SplitWorkspace &workspace) -> void {
   const auto &instance = solution.instance();
   assert(solution.visited_node_cnt() == instance.customer_cnt());
-  auto &tour = solution.base();
+  const auto &tour = std::as_const(solution).base();
+  workspace.reset(instance.customer_cnt(), 1UZ);
 
-  auto lambda = std::deque<size_t>();
-  lambda.push_back(0UZ);
-
-  auto d = std::vector(instance.customer_cnt(), 0.0);
-  auto q = std::vector(instance.customer_cnt(), 0.0);
-  q[0] = instance.demand(tour[0]);
+  auto &d = workspace.distance;
+  auto &q = workspace.load;
+  d[0] = 0.0;
+  q[0] = 0.0;
+  q[1] = instance.demand(tour[0]);
 
   for (auto i = 1UZ; i < instance.customer_cnt(); ++i) {
     d[i] = d[i - 1] + instance.distance(tour[i - 1], tour[i]);
-    q[i] = q[i - 1] + instance.demand(tour[i]);
+    q[i + 1] = q[i] + instance.demand(tour[i]);
   }
 
-  auto p = std::vector(instance.customer_cnt() + 1, std::numeric_limits<double>::infinity());
-  auto pred = std::vector(instance.customer_cnt() + 1, 0UZ);
+  auto &p = workspace.cost;
+  auto &pred = workspace.pred;
   p[0] = 0;
 
+  // Double-ended queue of route starts, every customer enters it at most once
+  auto &lambda = workspace.queue;
+  auto head = 0UZ;
+  auto tail = 0UZ;
+  lambda[tail++] = 0UZ;
+
   auto cost = [&](size_t i, size_t j) {
     auto ret = instance.distance(instance.depot_id(), tour[i]);
     ret += d[j - 1] - d[i];
@@ -444,32 +1000,32 @@ auto cye::linear_split(Solution &solution) -> void {
   auto dominates = [&](size_t i, size_t j) {
     if (p[i] + instance.distance(instance.depot_id(), tour[i]) - d[i] <=
         p[j] + instance.distance(instance.depot_id(), tour[j]) - d[j]) {
-      if ((i <= j && q[i] == q[j]) || i > j) return true;
+      if ((i <= j && q[i + 1] == q[j + 1]) || i > j) return true;
     }
     return false;
   };
 
   for (auto t = 1UZ; t <= instance.customer_cnt(); ++t) {
-    p[t] = p[lambda.front()] + cost(lambda.front(), t);
-    pred[t] = lambda.front();
+    p[t] = p[lambda[head]] + cost(lambda[head], t);
+    pred[t] = lambda[head];
 
     if (t < instance.customer_cnt()) {
-      if (!dominates(lambda.back(), t)) {
-        while (!lambda.empty() && dominates(t, lambda.back())) {
-          lambda.pop_back();
+      if (!dominates(lambda[tail - 1], t)) {
+        while (head < tail && dominates(t, lambda[tail - 1])) {
+          --tail;
         }
-        lambda.push_back(t);
+        lambda[tail++] = t;
       }
 
-      while (q[t] > instance.cargo_capacity() + (lambda.front() == 0 ? 0.0 : q[lambda.front() - 1])) {
-        lambda.pop_front();
+      while (q[t + 1] > instance.cargo_capacity() + q[lambda[head]]) {
+        ++head;
       }
     }
   }
 
   auto patch = Patch<size_t>();
   patch.add_change(instance.customer_cnt(), instance.depot_id());
-  auto i = pred.back();
+  auto i = pred[instance.customer_cnt()];
   while (i != 0) {
     patch.add_change(i, instance.depot_id());
     i = pred[i];
@@ -477,4 +1033,168 @@ auto cye::linear_split(Solution &solution) -> void {
   patch.add_change(0, instance.depot_id());
   patch.reverse();
   solution.add_patch(std::move(patch));
-}
\ No newline at end of file
+}
+
+auto cye::linear_split(std::span<Solution> solutions, std::span<SplitWorkspace> workspaces) -> void {
+  assert(!workspaces.empty());
+  auto split_every = [&](size_t first) {
+    for (auto i = first; i < solutions.size(); i += workspaces.size()) {
+      linear_split(solutions[i], workspaces[first]);
+    }
+  };
+
+  if (workspaces.size() == 1 || solutions.size() <= 1) {
+    split_every(0UZ);
+    return;
+  }
+
+  auto threads = std::vector<std::jthread>();
+  threads.reserve(workspaces.size() - 1);
+  for (auto first = 1UZ; first < workspaces.size(); ++first) {
+    threads.emplace_back(split_every, first);
+  }
+  split_every(0UZ);
+}
+
+auto cye::CargoLabelWorkspace::retire(size_t front_cnt) -> void {
+  retired_first_ = front_cnt;
+  retired_labels_.assign(labels_.begin() + static_cast<std::ptrdiff_t>(offsets_[front_cnt]), labels_.end());
+  retired_offsets_.clear();
+  for (auto j = front_cnt; j < offsets_.size(); ++j) {
+    retired_offsets_.push_back(offsets_[j] - offsets_[front_cnt]);
+  }
+
+  labels_.resize(offsets_[front_cnt]);
+  offsets_.resize(front_cnt + 1);
+}
+
+auto cye::CargoLabelWorkspace::shift_from_retired(size_t j) const -> std::optional<double> {
+  auto current = front(j);
+  auto begin = retired_offsets_[j - retired_first_];
+  auto end = retired_offsets_[j - retired_first_ + 1];
+  auto retired = std::span<const Label>(retired_labels_.data() + begin, end - begin);
+  if (current.size() != retired.size()) return std::nullopt;
+
+  auto shift = current.front().dist - retired.front().dist;
+  for (auto i = 0UZ; i < current.size(); ++i) {
+    if (current[i].cargo != retired[i].cargo || current[i].parent != retired[i].parent ||
+        current[i].inserted != retired[i].inserted ||
+        std::abs(current[i].dist - retired[i].dist - shift) > 1e-9 * std::max(1.0, std::abs(current[i].dist))) {
+      return std::nullopt;
+    }
+  }
+
+  return shift;
+}
+
+auto cye::CargoLabelWorkspace::restore_retired(size_t j, double shift) -> void {
+  for (; j + 1 < retired_first_ + retired_offsets_.size(); ++j) {
+    for (auto i = retired_offsets_[j - retired_first_]; i < retired_offsets_[j - retired_first_ + 1]; ++i) {
+      auto label = retired_labels_[i];
+      label.dist += shift;
+      labels_.push_back(label);
+    }
+    finish_front();
+  }
+}
+
+auto cye::SplitWorkspace::reset(size_t customer_cnt, size_t max_route_cnt) -> void {
+  distance.resize(customer_cnt);
+  load.resize(customer_cnt + 1);
+  cost.assign((max_route_cnt + 1) * (customer_cnt + 1), std::numeric_limits<double>::infinity());
+  pred.resize((max_route_cnt + 1) * (customer_cnt + 1));
+  queue.resize(customer_cnt + 1);
+}
+
+auto cye::SplitWorkspace::memory_usage() const -> size_t {
+  return (distance.capacity() + load.capacity() + cost.capacity()) * sizeof(double) +
+         (pred.capacity() + queue.capacity()) * sizeof(size_t);
+}
+
+auto cye::fleet_split(Solution &solution, size_t max_route_cnt) -> bool {
+  return fleet_split(solution, max_route_cnt, split_workspace);
+}
+
+auto cye::fleet_split(Solution &solution, size_t max_route_cnt, SplitWorkspace &workspace) -> bool {
+  const auto &instance = solution.instance();
+  assert(solution.visited_node_cnt() == instance.customer_cnt());
+  const auto &tour = std::as_const(solution).base();
+  auto customer_cnt = tour.size();
+  auto row = customer_cnt + 1;
+  workspace.reset(customer_cnt, max_route_cnt);
+
+  workspace.distance[0] = 0.0;
+  workspace.load[0] = 0.0;
+  for (auto t = 0UZ; t < customer_cnt; ++t) {
+    if (t > 0) {
+      workspace.distance[t] = workspace.distance[t - 1] + instance.distance(tour[t - 1], tour[t]);
+    }
+    workspace.load[t + 1] = workspace.load[t] + instance.demand(tour[t]);
+  }
+
+  workspace.cost[0] = 0.0;
+  auto best_route_cnt = 0UZ;
+  auto best_cost = std::numeric_limits<double>::infinity();
+
+  for (auto k = 1UZ; k <= max_route_cnt; ++k) {
+    const auto *previous = workspace.cost.data() + (k - 1) * row;
+    auto *current = workspace.cost.data() + k * row;
+    auto *pred = workspace.pred.data() + k * row;
+
+    // Cost of serving the first i customers with k - 1 routes and starting the k-th route at customer i, minus the
+    // part of the tour the route has not driven yet
+    auto key = [&](size_t i) {
+      return previous[i] + instance.distance(instance.depot_id(), tour[i]) - workspace.distance[i];
+    };
+
+    // Route starts that are still feasible, in increasing order of both position and key
+    auto head = 0UZ;
+    auto tail = 0UZ;
+    auto reached = false;
+
+    for (auto t = 1UZ; t <= customer_cnt; ++t) {
+      // A later start stays feasible at least as long, so it dominates every earlier start with a larger key
+      if (previous[t - 1] != std::numeric_limits<double>::infinity()) {
+        auto start_key = key(t - 1);
+        while (tail > head && key(workspace.queue[tail - 1]) >= start_key) {
+          --tail;
+        }
+        workspace.queue[tail++] = t - 1;
+      }
+
+      while (head < tail && workspace.load[t] - workspace.load[workspace.queue[head]] > instance.cargo_capacity()) {
+        ++head;
+      }
+
+      if (head < tail) {
+        current[t] = key(workspace.queue[head]) + workspace.distance[t - 1] +
+                     instance.distance(tour[t - 1], instance.depot_id());
+        pred[t] = workspace.queue[head];
+        reached = true;
+      }
+    }
+
+    if (current[customer_cnt] < best_cost) {
+      best_cost = current[customer_cnt];
+      best_route_cnt = k;
+    }
+
+    // No customer can be reached with k routes, so none can with more
+    if (!reached) break;
+  }
+
+  if (best_route_cnt == 0) return false;
+
+  auto patch = Patch<size_t>();
+  patch.add_change(customer_cnt, instance.depot_id());
+  auto t = customer_cnt;
+  for (auto k = best_route_cnt; k > 1; --k) {
+    t = workspace.pred[k * row + t];
+    patch.add_change(t, instance.depot_id());
+  }
+  patch.add_change(0, instance.depot_id());
+  patch.reverse();
+  solution.add_patch(std::move(patch));
+
+  return true;
+}
@@ -0,0 +1,141 @@
+#include "cye/route_cache.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <span>
+#include <vector>
+
+cye::RouteCache::RouteCache(size_t memory_budget, size_t shard_cnt)
+    : shard_memory_budget_(memory_budget / std::max(shard_cnt, 1UZ)), shards_(std::max(shard_cnt, 1UZ)) {}
+
+auto cye::RouteCache::hash(size_t network_id, std::span<const size_t> route) -> size_t {
+  auto hash = 14695981039346656037UZ;
+  hash *= 1099511628211UZ;
+  hash ^= network_id;
+  for (auto node_id : route) {
+    hash *= 1099511628211UZ;
+    hash ^= node_id;
+  }
+  return hash;
+}
+
+auto cye::RouteCache::slot_memory_(Slot_ const &slot) -> size_t {
+  // The slot, its vectors and roughly one node of the index
+  return sizeof(Slot_) + slot.route.capacity() * sizeof(size_t) + slot.detours.capacity() * sizeof(ChargingDetour) +
+         4 * sizeof(size_t);
+}
+
+auto cye::RouteCache::shard_(size_t hash) -> Shard_ & { return shards_[(hash ^ (hash >> 32)) % shards_.size()]; }
+
+auto cye::RouteCache::find(size_t network_id, size_t hash, std::span<const size_t> route,
+                           std::vector<ChargingDetour> &detours, double &cost) -> bool {
+  auto &shard = shard_(hash);
+  auto lock = std::lock_guard(shard.mutex);
+
+  auto it = shard.slot_inds.find(hash);
+  if (it == shard.slot_inds.end() || shard.slots[it->second].network_id != network_id ||
+      !std::ranges::equal(shard.slots[it->second].route, route)) {
+    miss_cnt_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  auto &slot = shard.slots[it->second];
+  slot.referenced = true;
+  detours.assign(slot.detours.begin(), slot.detours.end());
+  cost = slot.cost;
+  hit_cnt_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+auto cye::RouteCache::insert(size_t network_id, size_t hash, std::span<const size_t> route,
+                             std::span<const ChargingDetour> detours, double cost) -> void {
+  auto &shard = shard_(hash);
+  auto lock = std::lock_guard(shard.mutex);
+
+  // A route with the same hash is overwritten, whether it is the same route or a collision
+  auto [it, inserted] = shard.slot_inds.try_emplace(hash, 0UZ);
+  if (inserted) {
+    if (shard.free_slot_inds.empty()) {
+      it->second = shard.slots.size();
+      shard.slots.emplace_back();
+    } else {
+      it->second = shard.free_slot_inds.back();
+      shard.free_slot_inds.pop_back();
+    }
+  } else {
+    shard.memory_usage -= slot_memory_(shard.slots[it->second]);
+  }
+
+  auto &slot = shard.slots[it->second];
+  slot.network_id = network_id;
+  slot.hash = hash;
+  slot.route.assign(route.begin(), route.end());
+  slot.detours.assign(detours.begin(), detours.end());
+  slot.cost = cost;
+  slot.referenced = true;
+  slot.occupied = true;
+  shard.memory_usage += slot_memory_(slot);
+
+  // The route just inserted is never the victim
+  while (shard.memory_usage > shard_memory_budget_ && shard.slot_inds.size() > 1) {
+    evict_(shard, it->second);
+  }
+}
+
+auto cye::RouteCache::evict_(Shard_ &shard, size_t kept_slot_ind) -> void {
+  // Every referenced slot the hand passes gets a second chance, so a full turn always finds a victim
+  while (true) {
+    auto &slot = shard.slots[shard.hand];
+    auto ind = shard.hand;
+    shard.hand = (shard.hand + 1) % shard.slots.size();
+
+    if (!slot.occupied || ind == kept_slot_ind) continue;
+    if (slot.referenced) {
+      slot.referenced = false;
+      continue;
+    }
+
+    shard.memory_usage -= slot_memory_(slot);
+    shard.slot_inds.erase(slot.hash);
+    slot.route = std::vector<size_t>();
+    slot.detours = std::vector<ChargingDetour>();
+    slot.occupied = false;
+    shard.free_slot_inds.push_back(ind);
+    return;
+  }
+}
+
+auto cye::RouteCache::clear() -> void {
+  for (auto &shard : shards_) {
+    auto lock = std::lock_guard(shard.mutex);
+    shard.slot_inds.clear();
+    shard.slots.clear();
+    shard.free_slot_inds.clear();
+    shard.hand = 0;
+    shard.memory_usage = 0;
+  }
+}
+
+auto cye::RouteCache::hit_rate() const -> double {
+  auto hits = hit_cnt();
+  auto lookups = hits + miss_cnt();
+  return lookups == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(lookups);
+}
+
+auto cye::RouteCache::route_cnt() const -> size_t {
+  auto cnt = 0UZ;
+  for (auto const &shard : shards_) {
+    auto lock = std::lock_guard(shard.mutex);
+    cnt += shard.slot_inds.size();
+  }
+  return cnt;
+}
+
+auto cye::RouteCache::memory_usage() const -> size_t {
+  auto memory = 0UZ;
+  for (auto const &shard : shards_) {
+    auto lock = std::lock_guard(shard.mutex);
+    memory += shard.memory_usage;
+  }
+  return memory;
+}
@@ -1,78 +1,86 @@
 #include "cye/solution.hpp"
 #include <cassert>
 #include <cstddef>
+#include <span>
 #include <unordered_set>
 #include <vector>
 
 cye::Solution::Solution(std::shared_ptr<Instance> instance, std::vector<size_t> &&routes)
     : instance_(instance), routes_(std::move(routes)) {}
 
-cye::Solution::Solution(std::shared_ptr<Instance> instance, PatchableVector<size_t> &&routes)
+cye::Solution::Solution(std::shared_ptr<Instance> instance, Routes &&routes)
     : instance_(instance), routes_(routes) {}
 
 auto cye::Solution::is_cargo_valid() const -> bool {
   auto cargo = instance_->cargo_capacity();
+  auto valid = true;
 
-  for (auto node_id : routes_) {
-    const auto &node = instance_->node(node_id);
-    switch (node.type) {
-      case NodeType::Depot:
-        cargo = instance_->cargo_capacity();
-        break;
-      case NodeType::Customer:
-        cargo -= node.demand;
-        if (cargo < 0) {
-          return false;
-        }
-        break;
-      case NodeType::ChargingStation:
-        break;
+  routes_.for_each_segment([&](std::span<const size_t> segment) {
+    for (auto node_id : segment) {
+      const auto &node = instance_->node(node_id);
+      switch (node.type) {
+        case NodeType::Depot:
+          cargo = instance_->cargo_capacity();
+          break;
+        case NodeType::Customer:
+          cargo -= node.demand;
+          valid = valid && cargo >= 0;
+          break;
+        case NodeType::ChargingStation:
+          break;
+      }
     }
-  }
+  });
 
-  return true;
+  return valid;
 }
 
 auto cye::Solution::is_energy_and_cargo_valid() const -> bool {
   auto energy = instance_->battery_capacity();
   auto cargo = instance_->cargo_capacity();
+  auto valid = true;
 
-  auto previous_node_id = *routes_.begin();
-  for (auto it = ++routes_.begin(); it != routes_.end(); ++it) {
-    auto current_node_id = *it;
-    energy -= instance_->energy_required(previous_node_id, current_node_id);
-    if (energy < 0) {
-      return false;
-    }
+  // The energy from a node to itself is zero, so seeding with the first node lets the first segment start for free
+  auto previous_node_id = routes_[0];
+  routes_.for_each_segment([&](std::span<const size_t> segment) {
+    for (auto current_node_id : segment) {
+      energy -= instance_->energy_required(previous_node_id, current_node_id);
+      valid = valid && energy >= 0;
 
-    auto &node = instance_->node(current_node_id);
-    switch (node.type) {
-      case NodeType::Depot:
-        energy = instance_->battery_capacity();
-        cargo = instance_->cargo_capacity();
-        break;
-      case NodeType::Customer:
-        cargo -= node.demand;
-        if (cargo < 0) {
-          return false;
-        }
-        break;
-      case NodeType::ChargingStation:
-        energy = instance_->battery_capacity();
-        break;
+      auto &node = instance_->node(current_node_id);
+      switch (node.type) {
+        case NodeType::Depot:
+          energy = instance_->battery_capacity();
+          cargo = instance_->cargo_capacity();
+          break;
+        case NodeType::Customer:
+          cargo -= node.demand;
+          valid = valid && cargo >= 0;
+          break;
+        case NodeType::ChargingStation:
+          energy = instance_->battery_capacity();
+          break;
+      }
+      previous_node_id = current_node_id;
     }
-    previous_node_id = current_node_id;
-  }
+  });
 
-  return true;
+  return valid;
 }
 
 auto cye::Solution::is_valid() const -> bool {
-  if (*routes_.begin() != instance_->depot_id() || *(routes_.rbegin()) != instance_->depot_id()) return false;
+  if (routes_[0] != instance_->depot_id() || routes_[routes_.size() - 1] != instance_->depot_id()) return false;
 
-  auto is_customer = [this](size_t ind) { return instance_->node(ind).type == NodeType::Customer; };
-  size_t customer_cnt = std::ranges::count_if(routes_, is_customer);
-  auto customers_on_route = std::ranges::to<std::unordered_set<size_t>>(routes_ | std::views::filter(is_customer));
+  auto customer_cnt = 0UZ;
+  auto customers_on_route = std::unordered_set<size_t>();
+  routes_.for_each_segment([&](std::span<const size_t> segment) {
+    for (auto node_id : segment) {
+      if (instance_->node(node_id).type == NodeType::Customer) {
+        ++customer_cnt;
+        customers_on_route.insert(node_id);
+      }
+    }
+  });
 
   if (instance_->customer_cnt() != customer_cnt || customers_on_route.size() != customer_cnt) return false;
 
@@ -81,11 +89,14 @@ auto cye::Solution::is_valid() const -> bool {
 
 auto cye::Solution::cost() const -> double {
   auto cost = 0.0;
-  auto previous_node_id = *routes_.begin();
-  for (auto it = ++routes_.begin(); it != routes_.end(); ++it) {
-    auto current_node_id = *it;
-    cost += instance_->distance(previous_node_id, current_node_id);
-    previous_node_id = current_node_id;
-  }
+  // The distance of a node to itself is zero, so seeding with the first node makes the first segment start for free
+  auto previous_node_id = routes_[0];
+  routes_.for_each_segment([&](std::span<const size_t> segment) {
+    cost += instance_->distance(previous_node_id, segment.front());
+    for (auto i = 1UZ; i < segment.size(); ++i) {
+      cost += instance_->distance(segment[i - 1], segment[i]);
+    }
+    previous_node_id = segment.back();
+  });
   return cost;
 }
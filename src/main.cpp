@@ -7,6 +7,7 @@
 #include <filesystem>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <random>
 #include <vector>
 
@@ -26,7 +27,8 @@ struct Config {
   size_t population_size = 200;
   size_t generation_cnt = 1000;
   size_t elite_cnt = 30;
-  size_t energy_repair_bins = 100001;
+  // Routes an individual may use, empty leaves the fleet unlimited
+  std::optional<size_t> max_route_cnt;
 };
 
 auto measurement(Config const &config) -> double {
@@ -48,7 +50,8 @@ auto measurement(Config const &config) -> double {
   auto population = std::vector<cye::EVRPIndividual>();
   population.reserve(config.population_size);
   for (size_t i = 0; i < config.population_size; ++i) {
-    population.emplace_back(energy_repair, cye::stochastic_rank_nearest_neighbor(gen, instance, 3));
+    population.emplace_back(energy_repair, cye::stochastic_rank_nearest_neighbor(gen, instance, 3),
+                            config.max_route_cnt);
   }
 
   auto selection_operator = std::make_unique<meta::ga::RankSelection<cye::EVRPIndividual>>(1.60);
@@ -60,8 +63,8 @@ auto measurement(Config const &config) -> double {
   ga.add_mutation_operator(std::make_unique<cye::HMM>(instance));
   ga.add_mutation_operator(std::make_unique<cye::HSM>(instance));
 
-  ga.add_local_search(std::make_unique<cye::TwoOptSearch>(instance));
-  ga.add_local_search(std::make_unique<cye::SwapSearch>(instance));
+  ga.add_local_search(std::make_unique<cye::TwoOptSearch>(energy_repair, instance));
+  ga.add_local_search(std::make_unique<cye::SwapSearch>(energy_repair, instance));
 
   ga.optimize(gen);
   auto best_individual = ga.best_individual();
@@ -69,8 +72,8 @@ auto measurement(Config const &config) -> double {
 
   auto solution = best_individual.solution();
   solution.clear_patches();
-  cye::patch_cargo_optimally(solution, static_cast<unsigned>(instance->cargo_capacity()) + 1u);
-  energy_repair->patch(solution, config.energy_repair_bins);
+  cye::patch_cargo_optimally(solution);
+  energy_repair->patch(solution);
 
   best_cost = std::min(best_cost, solution.cost());
 
@@ -1,4 +1,8 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include "cye/destroy.hpp"
 #include "cye/init_heuristics.hpp"
 #include "cye/instance.hpp"
 
@@ -12,4 +16,39 @@ TEST(Heuristics, NearestNeighbor) {
 
     EXPECT_TRUE(solution.is_valid());
   }
-}
\ No newline at end of file
+}
+
+TEST(Heuristics, RandomDestroy) {
+  auto gen = meta::RandomEngine(0);
+
+  for (const auto &path : std::filesystem::directory_iterator("dataset/json")) {
+    auto archive = serial::JSONArchive(path);
+    auto instance = std::make_shared<cye::Instance>(archive.root());
+    auto solution = cye::nearest_neighbor(instance);
+
+    auto customers = std::vector<size_t>();
+    for (auto node_id : std::as_const(solution).base()) {
+      if (instance->is_customer(node_id)) customers.push_back(node_id);
+    }
+
+    auto destroyed = cye::random_destroy(std::move(solution), gen, 0.5);
+    auto &base = std::as_const(destroyed).base();
+
+    // The removal patch hides every depot and station, and the removed customers are the ones missing from the route
+    auto removed = std::vector<size_t>();
+    for (auto ind : destroyed.get_patch(0).removals()) {
+      if (instance->is_customer(base[ind])) removed.push_back(base[ind]);
+    }
+    auto expected = std::vector<size_t>();
+    for (auto customer_id : customers) {
+      if (std::ranges::find(removed, customer_id) == removed.end()) expected.push_back(customer_id);
+    }
+
+    auto route = std::vector<size_t>();
+    for (auto node_id : destroyed.routes()) {
+      route.push_back(node_id);
+    }
+    EXPECT_EQ(route, expected);
+    EXPECT_EQ(route.size() + removed.size(), customers.size());
+  }
+}
@@ -0,0 +1,93 @@
+#include "cye/individual.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+#include "cye/repair.hpp"
+#include "cye/solution.hpp"
+
+namespace {
+
+// The depot also charges, so the routes are counted from the positions of the depots of the cargo split, which is the
+// first patch
+auto route_cnt(cye::Solution const &solution) { return solution.get_patch(0).changes().size() - 1; }
+
+}  // namespace
+
+TEST(Individual, FleetLimit) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  for (const auto &path : std::filesystem::directory_iterator("dataset/json")) {
+    auto archive = serial::JSONArchive(path);
+    auto instance = std::make_shared<cye::Instance>(archive.root());
+    auto energy_repair = std::make_shared<cye::OptimalEnergyRepair>(instance);
+
+    auto routes = std::vector<size_t>();
+    for (auto c : instance->customer_ids()) {
+      routes.push_back(c);
+    }
+
+    for (auto i = 0UZ; i < 5UZ; i++) {
+      std::shuffle(routes.begin(), routes.end(), gen);
+
+      auto unlimited = cye::EVRPIndividual(energy_repair, cye::Solution(instance, std::vector(routes)));
+      auto unlimited_route_cnt = route_cnt(std::as_const(unlimited).solution());
+
+      // One route less than the unlimited split needs, unless that is below what the cargo allows. The fleet-limited
+      // split only runs when the unlimited one needs too many routes.
+      auto max_route_cnt = std::max(unlimited_route_cnt - 1, instance->minimum_route_cnt());
+      auto limited = cye::EVRPIndividual(energy_repair, cye::Solution(instance, std::vector(routes)), max_route_cnt);
+
+      auto limited_solution = cye::Solution(instance, std::vector(routes));
+      auto expected_route_cnt = unlimited_route_cnt;
+      if (unlimited_route_cnt > max_route_cnt && cye::fleet_split(limited_solution, max_route_cnt)) {
+        expected_route_cnt = route_cnt(limited_solution);
+        EXPECT_LE(expected_route_cnt, max_route_cnt);
+      }
+
+      EXPECT_TRUE(std::as_const(limited).solution().is_valid());
+      EXPECT_EQ(route_cnt(std::as_const(limited).solution()), expected_route_cnt);
+    }
+  }
+}
+
+TEST(Individual, IncrementalSplit) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  auto archive = serial::JSONArchive("dataset/json/X-n143-k7.json");
+  auto instance = std::make_shared<cye::Instance>(archive.root());
+  auto energy_repair = std::make_shared<cye::OptimalEnergyRepair>(instance);
+
+  auto routes = std::vector<size_t>();
+  for (auto c : instance->customer_ids()) {
+    routes.push_back(c);
+  }
+  std::shuffle(routes.begin(), routes.end(), gen);
+  auto parent = cye::EVRPIndividual(energy_repair, cye::Solution(instance, std::move(routes)));
+  auto swap_ind = std::uniform_int_distribution<size_t>(0, instance->customer_cnt() - 2);
+
+  for (auto i = 0UZ; i < 50UZ; i++) {
+    // A copy shares the genotype of its parent until it is edited
+    auto child = parent;
+    EXPECT_TRUE(std::as_const(child).solution().routes().shares_base_with(std::as_const(parent).solution().routes()));
+
+    auto ind = swap_ind(gen);
+    std::swap(child.genotype()[ind], child.genotype()[ind + 1]);
+    child.update_cost();
+
+    // The split continues from the fronts of the parent, it has to agree with one from scratch
+    auto genotype = std::as_const(child).genotype();
+    auto fresh = cye::Solution(instance, std::move(genotype));
+    auto workspace = cye::CargoLabelWorkspace();
+    cye::patch_cargo_optimally(fresh, workspace);
+    energy_repair->patch(fresh);
+    EXPECT_NEAR(child.cost(), fresh.cost(), 1e-6);
+
+    parent = child;
+  }
+}
@@ -18,4 +18,48 @@ TEST(Instance, Distance) {
       }
     }
   }
-}
\ No newline at end of file
+}
+
+TEST(Instance, CargoQuantum) {
+  for (const auto &path : std::filesystem::directory_iterator("dataset/json")) {
+    auto archive = serial::JSONArchive(path);
+    auto instance = cye::Instance(archive.root());
+    auto quantum = instance.cargo_quantum();
+
+    EXPECT_EQ(std::fmod(instance.cargo_capacity(), quantum), 0.0);
+    for (auto customer_id : instance.customer_ids()) {
+      EXPECT_EQ(std::fmod(instance.nodes()[customer_id].demand, quantum), 0.0);
+    }
+    EXPECT_EQ(instance.cargo_bin_cnt(), static_cast<unsigned>(instance.cargo_capacity() / quantum) + 1u);
+  }
+
+  auto archive = serial::JSONArchive("dataset/json/E-n22-k4.json");
+  auto instance = cye::Instance(archive.root());
+  EXPECT_EQ(instance.cargo_quantum(), 100.0);
+  EXPECT_EQ(instance.cargo_bin_cnt(), 61u);
+}
+
+TEST(Instance, ReachableStations) {
+  for (const auto &path : std::filesystem::directory_iterator("dataset/json")) {
+    auto archive = serial::JSONArchive(path);
+    auto instance = cye::Instance(archive.root());
+
+    for (auto node_id = 0UZ; node_id < instance.node_cnt(); ++node_id) {
+      auto station_ids = instance.reachable_station_ids(node_id);
+
+      // Every station the battery gets to is listed once, nearest first
+      auto station_cnt = 0UZ;
+      for (auto station_id = 0UZ; station_id < instance.node_cnt(); ++station_id) {
+        if (station_id != node_id && instance.is_charging_station(station_id) &&
+            instance.energy_required(node_id, station_id) <= instance.battery_capacity()) {
+          ++station_cnt;
+          EXPECT_EQ(std::ranges::count(station_ids, station_id), 1);
+        }
+      }
+      EXPECT_EQ(station_ids.size(), station_cnt);
+      for (auto i = 1UZ; i < station_ids.size(); ++i) {
+        EXPECT_LE(instance.distance(node_id, station_ids[i - 1]), instance.distance(node_id, station_ids[i]));
+      }
+    }
+  }
+}
@@ -4,6 +4,8 @@
 #include <cstddef>
 #include <random>
 #include <ranges>
+#include <span>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -444,4 +446,596 @@ TEST(PatchableVector, DecrementStress) {
       prev_it = it;
     }
   }
-}
\ No newline at end of file
+}
+
+TEST(PatchableVector, View) {
+  auto vec = cye::PatchableVector<size_t>{0, 1, 2, 3, 4, 5};
+  const auto &ref = vec;
+
+  auto view = ref.view();
+  EXPECT_EQ(std::vector<size_t>(view.begin(), view.end()), (std::vector<size_t>{0, 1, 2, 3, 4, 5}));
+
+  auto patch = cye::Patch<size_t>();
+  patch.add_change(0, 10);
+  patch.add_change(3, 20);
+  vec.add_patch(std::move(patch));
+
+  view = ref.view();
+  EXPECT_EQ(std::vector<size_t>(view.begin(), view.end()), (std::vector<size_t>{10, 0, 1, 2, 20, 3, 4, 5}));
+
+  vec.base()[1] = 30;
+  view = ref.view();
+  EXPECT_EQ(std::vector<size_t>(view.begin(), view.end()), (std::vector<size_t>{10, 0, 30, 2, 20, 3, 4, 5}));
+
+  vec.pop_patch();
+  view = ref.view();
+  EXPECT_EQ(std::vector<size_t>(view.begin(), view.end()), (std::vector<size_t>{0, 30, 2, 3, 4, 5}));
+}
+
+TEST(PatchableVector, RandomAccess) {
+  auto vec = cye::PatchableVector<size_t>{0, 1, 2, 3, 4, 5};
+  auto patch = cye::Patch<size_t>();
+  patch.add_change(0, 10);
+  patch.add_change(0, 15);
+  patch.add_change(1, 20);
+  vec.add_patch(std::move(patch));
+
+  auto patch2 = cye::Patch<size_t>();
+  patch2.add_change(0, 30);
+  patch2.add_change(1, 40);
+  patch2.add_change(9, 50);
+  vec.add_patch(std::move(patch2));
+
+  auto expected = std::vector<size_t>{30, 10, 40, 15, 0, 20, 1, 2, 3, 4, 5, 50};
+  ASSERT_EQ(vec.size(), expected.size());
+  for (auto i = 0UZ; i < expected.size(); ++i) {
+    EXPECT_EQ(vec[i], expected[i]);
+  }
+
+  EXPECT_EQ(vec.at(11), 50);
+  EXPECT_THROW((void)vec.at(12), std::out_of_range);
+}
+
+TEST(PatchableVector, RandomAccessStress) {
+  auto rd = std::random_device();
+  auto gen = std::mt19937(rd());
+
+  auto dist = std::uniform_int_distribution(1UZ, 100UZ);
+  auto patch_cnt_dist = std::uniform_int_distribution(0UZ, 5UZ);
+
+  for (auto iter = 0UZ; iter < 1000UZ; ++iter) {
+    auto elements = std::vector<size_t>();
+    auto element_cnt = dist(gen);
+    for (auto i = 0UZ; i < element_cnt; ++i) elements.push_back(i);
+
+    auto patchable_vec = cye::PatchableVector<size_t>(std::move(elements));
+
+    auto patch_cnt = patch_cnt_dist(gen);
+    for (auto p = 0UZ; p < patch_cnt; ++p) {
+      auto insertion_dist = std::uniform_int_distribution(0UZ, patchable_vec.size());
+      std::vector<std::pair<size_t, size_t>> changes;
+      auto change_cnt = dist(gen);
+
+      for (auto i = 0UZ; i < change_cnt; ++i) {
+        // Inserted values are distinguishable from the base indices.
+        changes.emplace_back(insertion_dist(gen), 1000UZ + dist(gen));
+      }
+      std::ranges::sort(changes);
+
+      auto patch = cye::Patch<size_t>();
+      for (auto [ind, value] : changes) {
+        patch.add_change(ind, value);
+      }
+      patchable_vec.add_patch(std::move(patch));
+    }
+
+    auto squashed = patchable_vec;
+    squashed.squash();
+    auto &expected = squashed.base();
+
+    ASSERT_EQ(patchable_vec.size(), expected.size());
+    for (auto i = 0UZ; i < expected.size(); ++i) {
+      EXPECT_EQ(patchable_vec[i], expected[i]);
+
+      // Base elements are their own base index, so the lower bound can be checked against a linear scan.
+      auto next_base = std::ranges::find_if(expected.begin() + static_cast<std::ptrdiff_t>(i), expected.end(),
+                                            [](auto value) { return value < 1000UZ; });
+      auto expected_lower_bound = next_base == expected.end() ? element_cnt : *next_base;
+      EXPECT_EQ(patchable_vec.base_lower_bound(i), expected_lower_bound);
+    }
+
+    for (auto base_ind = 0UZ; base_ind < element_cnt; ++base_ind) {
+      EXPECT_EQ(expected[patchable_vec.patched_index(base_ind)], base_ind);
+    }
+  }
+}
+
+TEST(PatchableVector, ForEachSegment) {
+  auto rd = std::random_device();
+  auto gen = std::mt19937(rd());
+
+  auto dist = std::uniform_int_distribution(1UZ, 100UZ);
+  auto patch_cnt_dist = std::uniform_int_distribution(0UZ, 5UZ);
+
+  for (auto iter = 0UZ; iter < 1000UZ; ++iter) {
+    auto elements = std::vector<size_t>();
+    auto element_cnt = dist(gen);
+    for (auto i = 0UZ; i < element_cnt; ++i) elements.push_back(i);
+
+    auto patchable_vec = cye::PatchableVector<size_t>(std::move(elements));
+
+    auto patch_cnt = patch_cnt_dist(gen);
+    for (auto p = 0UZ; p < patch_cnt; ++p) {
+      auto insertion_dist = std::uniform_int_distribution(0UZ, patchable_vec.size());
+      std::vector<std::pair<size_t, size_t>> changes;
+      auto change_cnt = dist(gen);
+
+      for (auto i = 0UZ; i < change_cnt; ++i) {
+        changes.emplace_back(insertion_dist(gen), dist(gen));
+      }
+      std::ranges::sort(changes);
+
+      auto patch = cye::Patch<size_t>();
+      for (auto [ind, value] : changes) {
+        patch.add_change(ind, value);
+      }
+      patchable_vec.add_patch(std::move(patch));
+    }
+
+    auto concatenated = std::vector<size_t>();
+    patchable_vec.for_each_segment([&](std::span<const size_t> segment) {
+      EXPECT_FALSE(segment.empty());
+      concatenated.insert(concatenated.end(), segment.begin(), segment.end());
+    });
+
+    auto squashed = patchable_vec;
+    squashed.squash();
+    EXPECT_EQ(concatenated, squashed.base());
+  }
+}
+
+TEST(PatchableVector, MergePatches) {
+  auto rd = std::random_device();
+  auto gen = std::mt19937(rd());
+
+  auto dist = std::uniform_int_distribution(1UZ, 100UZ);
+  auto patch_cnt_dist = std::uniform_int_distribution(2UZ, 5UZ);
+
+  for (auto iter = 0UZ; iter < 1000UZ; ++iter) {
+    auto elements = std::vector<size_t>();
+    auto element_cnt = dist(gen);
+    for (auto i = 0UZ; i < element_cnt; ++i) elements.push_back(i);
+
+    auto patchable_vec = cye::PatchableVector<size_t>(std::move(elements));
+
+    auto patch_cnt = patch_cnt_dist(gen);
+    for (auto p = 0UZ; p < patch_cnt; ++p) {
+      auto insertion_dist = std::uniform_int_distribution(0UZ, patchable_vec.size());
+      std::vector<std::pair<size_t, size_t>> changes;
+      auto change_cnt = dist(gen);
+
+      for (auto i = 0UZ; i < change_cnt; ++i) {
+        changes.emplace_back(insertion_dist(gen), 100UZ + dist(gen));
+      }
+      std::ranges::sort(changes);
+
+      auto patch = cye::Patch<size_t>();
+      for (auto [ind, value] : changes) {
+        patch.add_change(ind, value);
+      }
+      patchable_vec.add_patch(std::move(patch));
+    }
+
+    auto expected = patchable_vec;
+    expected.squash();
+
+    auto merge_dist = std::uniform_int_distribution(0UZ, patch_cnt - 2UZ);
+    auto merged_one = patchable_vec;
+    merged_one.merge_patch(merge_dist(gen));
+    auto merged_all = patchable_vec;
+    merged_all.merge_patches();
+
+    ASSERT_EQ(merged_one.size(), expected.size());
+    ASSERT_EQ(merged_all.size(), expected.size());
+    EXPECT_EQ(merged_all.base(), patchable_vec.base());
+
+    auto result_one = std::vector<size_t>();
+    for (auto it = merged_one.begin(); it != merged_one.end(); ++it) {
+      result_one.push_back(*it);
+    }
+    EXPECT_EQ(result_one, expected.base());
+
+    auto result_all = std::vector<size_t>();
+    for (auto it = merged_all.begin(); it != merged_all.end(); ++it) {
+      result_all.push_back(*it);
+    }
+    EXPECT_EQ(result_all, expected.base());
+
+    auto &changes = merged_all.get_patch(0).changes();
+    for (auto i = 1UZ; i < changes.size(); ++i) {
+      EXPECT_LE(changes[i - 1].ind, changes[i].ind);
+    }
+  }
+}
+
+TEST(PatchableVector, CopyOnWrite) {
+  auto vec = cye::PatchableVector<size_t>({1, 2, 3, 4});
+  auto patch = cye::Patch<size_t>();
+  patch.add_change(2, 10);
+  vec.add_patch(std::move(patch));
+
+  auto copy = vec;
+  EXPECT_TRUE(copy.shares_base_with(vec));
+
+  // Reading does not detach
+  auto const &const_copy = copy;
+  EXPECT_EQ(const_copy[2], 10UZ);
+  EXPECT_EQ(*const_copy.begin(), 1UZ);
+  EXPECT_TRUE(copy.shares_base_with(vec));
+
+  copy.base()[0] = 5;
+  EXPECT_FALSE(copy.shares_base_with(vec));
+  EXPECT_EQ(vec.base(), (std::vector<size_t>{1, 2, 3, 4}));
+  EXPECT_EQ(copy.base(), (std::vector<size_t>{5, 2, 3, 4}));
+
+  auto view = vec.view();
+  auto view_copy = vec;
+  *view_copy.begin() = 7;
+  EXPECT_EQ(view_copy.view()[0], 7UZ);
+  EXPECT_EQ(view[0], 1UZ);
+  EXPECT_EQ(vec.view()[0], 1UZ);
+
+  auto squashed = vec;
+  squashed.squash();
+  EXPECT_EQ(squashed.base(), (std::vector<size_t>{1, 2, 10, 3, 4}));
+  EXPECT_EQ(vec.base(), (std::vector<size_t>{1, 2, 3, 4}));
+}
+
+TEST(PatchableVector, ReadsKeepBaseShared) {
+  auto vec = cye::PatchableVector<size_t, 4>{1, 2, 3, 4};
+  auto patch = cye::Patch<size_t>();
+  patch.add_change(2, 10);
+  vec.add_patch(std::move(patch));
+
+  // Reads of a non-const copy go through the const overloads and leave the base shared
+  auto copy = vec;
+  auto sum = 0UZ;
+  for (auto i = 0UZ; i < copy.size(); ++i) {
+    sum += std::as_const(copy)[i] + std::as_const(copy).at(i);
+  }
+  for (auto node : std::as_const(copy)) {
+    sum += node;
+  }
+  sum += *std::as_const(copy).rbegin();
+  copy.for_each_segment([&](std::span<const size_t> segment) {
+    for (auto node : segment) {
+      sum += node;
+    }
+  });
+  for (auto node : copy.view()) {
+    sum += node;
+  }
+  EXPECT_EQ(sum, 5UZ * 20UZ + 4UZ);
+  EXPECT_TRUE(copy.shares_base_with(vec));
+
+  // Mutable access is a write and detaches
+  copy[0] = 5;
+  EXPECT_FALSE(copy.shares_base_with(vec));
+  EXPECT_EQ(std::as_const(vec)[0], 1UZ);
+}
+
+TEST(PatchableVector, BoundedDepth) {
+  auto rd = std::random_device();
+  auto gen = std::mt19937(rd());
+
+  auto dist = std::uniform_int_distribution(1UZ, 50UZ);
+  auto patch_cnt_dist = std::uniform_int_distribution(1UZ, 9UZ);
+  auto coin = std::bernoulli_distribution(0.5);
+
+  for (auto iter = 0UZ; iter < 2000UZ; ++iter) {
+    auto elements = std::vector<size_t>();
+    auto element_cnt = dist(gen);
+    for (auto i = 0UZ; i < element_cnt; ++i) elements.push_back(dist(gen));
+
+    auto copy = elements;
+    auto patchable_vec = cye::PatchableVector<size_t, 4>(std::move(copy));
+
+    // The first patch may hide elements of the base, like the removals of a destroy operator
+    auto patch_cnt = patch_cnt_dist(gen);
+    for (auto p = 0UZ; p < patch_cnt; ++p) {
+      auto patch = cye::Patch<size_t>();
+      if (p == 0 && coin(gen)) {
+        auto kept = std::vector<size_t>();
+        for (auto ind = 0UZ; ind < elements.size(); ++ind) {
+          if (coin(gen)) {
+            patch.add_removal(ind);
+          } else {
+            kept.push_back(elements[ind]);
+          }
+        }
+        elements = std::move(kept);
+      }
+
+      auto insertion_dist = std::uniform_int_distribution(0UZ, elements.size());
+      std::vector<std::pair<size_t, size_t>> changes;
+      auto change_cnt = dist(gen);
+      for (auto i = 0UZ; i < change_cnt; ++i) {
+        changes.emplace_back(insertion_dist(gen), dist(gen));
+      }
+
+      std::ranges::sort(changes);
+      for (auto [ind, value] : changes | std::views::reverse) {
+        elements.insert(elements.begin() + static_cast<std::ptrdiff_t>(ind), value);
+      }
+      for (auto [ind, value] : changes) {
+        patch.add_change(ind, value);
+      }
+      patchable_vec.add_patch(std::move(patch));
+      ASSERT_LE(patchable_vec.patch_cnt(), 4UZ);
+      ASSERT_EQ(patchable_vec.size(), elements.size());
+
+      auto result = std::vector<size_t>();
+      for (auto it = patchable_vec.begin(); it != patchable_vec.end(); ++it) {
+        result.push_back(*it);
+      }
+      EXPECT_EQ(result, elements);
+
+      auto reversed = std::vector<size_t>();
+      auto it = patchable_vec.rbegin();
+      for (auto i = 0UZ; i < patchable_vec.size(); ++i) {
+        reversed.push_back(*it);
+        if (i + 1UZ < patchable_vec.size()) --it;
+      }
+      std::ranges::reverse(reversed);
+      EXPECT_EQ(reversed, elements);
+
+      for (auto i = 0UZ; i < elements.size(); ++i) {
+        EXPECT_EQ(std::as_const(patchable_vec)[i], elements[i]);
+      }
+      EXPECT_TRUE(std::ranges::equal(patchable_vec.view(), elements));
+    }
+  }
+}
+
+TEST(PatchableVector, BoundedDepthPop) {
+  auto vec = cye::PatchableVector<size_t, 4>{0, 1, 2, 3};
+  auto elements = [&] {
+    auto view = vec.view();
+    return std::vector(view.begin(), view.end());
+  };
+  auto states = std::vector<std::vector<size_t>>();
+  states.push_back(elements());
+
+  // One patch more than the bound, the last one is merged into the one below
+  for (auto p = 0UZ; p < 5UZ; ++p) {
+    auto patch = cye::Patch<size_t>();
+    patch.add_change(p, 10UZ + p);
+    vec.add_patch(std::move(patch));
+    states.push_back(elements());
+  }
+  EXPECT_EQ(vec.patch_cnt(), 4UZ);
+  EXPECT_EQ(elements(), states[5]);
+
+  // Popping the merged patch drops both, the patches below stay
+  for (auto p = 3UZ; p > 0UZ; --p) {
+    vec.pop_patch();
+    EXPECT_EQ(vec.patch_cnt(), p);
+    EXPECT_EQ(elements(), states[p]);
+  }
+}
+
+TEST(PatchableVector, Removal) {
+  auto vec = cye::PatchableVector<size_t>{0, 1, 2, 3, 4, 5};
+  auto patch = cye::Patch<size_t>();
+  patch.add_change(0, 10);
+  patch.add_change(1, 11);
+  patch.add_removal(0);
+  patch.add_removal(2);
+  patch.add_removal(5);
+  vec.add_patch(std::move(patch));
+
+  auto expected = std::vector<size_t>{10, 1, 11, 3, 4};
+  EXPECT_EQ(vec.size(), expected.size());
+
+  auto result = std::vector<size_t>();
+  for (auto it = vec.begin(); it != vec.end(); ++it) {
+    result.push_back(*it);
+  }
+  EXPECT_EQ(result, expected);
+
+  auto reversed = std::vector<size_t>();
+  auto it = vec.rbegin();
+  for (auto i = 0UZ; i < vec.size(); ++i) {
+    reversed.push_back(*it);
+    if (i + 1UZ < vec.size()) --it;
+  }
+  std::ranges::reverse(reversed);
+  EXPECT_EQ(reversed, expected);
+
+  auto prev_it = vec.begin();
+  for (auto it = ++vec.begin(); it != vec.end(); ++it) {
+    auto copy = it;
+    --copy;
+    EXPECT_EQ(prev_it, copy);
+    prev_it = it;
+  }
+}
+
+TEST(PatchableVector, RemovalStress) {
+  auto rd = std::random_device();
+  auto gen = std::mt19937(rd());
+
+  auto dist = std::uniform_int_distribution(1UZ, 100UZ);
+  auto patch_cnt_dist = std::uniform_int_distribution(0UZ, 4UZ);
+  auto coin = std::bernoulli_distribution(0.3);
+
+  for (auto iter = 0UZ; iter < 5000UZ; ++iter) {
+    auto elements = std::vector<size_t>();
+    auto element_cnt = dist(gen);
+    for (auto i = 0UZ; i < element_cnt; ++i) elements.push_back(i);
+
+    auto patchable_vec = cye::PatchableVector<size_t>(std::vector<size_t>(elements));
+
+    auto removal_patch = cye::Patch<size_t>();
+    auto kept = std::vector<size_t>();
+    for (auto i = 0UZ; i < element_cnt; ++i) {
+      if (coin(gen)) {
+        removal_patch.add_removal(i);
+      } else {
+        kept.push_back(elements[i]);
+      }
+    }
+    elements = std::move(kept);
+
+    auto patch_cnt = patch_cnt_dist(gen);
+    for (auto p = 0UZ; p <= patch_cnt; ++p) {
+      auto insertion_dist = std::uniform_int_distribution(0UZ, elements.size());
+      std::vector<std::pair<size_t, size_t>> changes;
+      auto change_cnt = dist(gen) % 20UZ;
+
+      for (auto i = 0UZ; i < change_cnt; ++i) {
+        changes.emplace_back(insertion_dist(gen), 100UZ + dist(gen));
+      }
+
+      std::ranges::sort(changes);
+      for (auto [ind, value] : changes | std::views::reverse) {
+        elements.insert(elements.begin() + static_cast<std::ptrdiff_t>(ind), value);
+      }
+
+      auto patch = p == 0 ? std::move(removal_patch) : cye::Patch<size_t>();
+      for (auto [ind, value] : changes) {
+        patch.add_change(ind, value);
+      }
+      patchable_vec.add_patch(std::move(patch));
+    }
+
+    ASSERT_EQ(patchable_vec.size(), elements.size());
+
+    auto result = std::vector<size_t>();
+    for (auto it = patchable_vec.begin(); it != patchable_vec.end(); ++it) {
+      result.push_back(*it);
+    }
+    EXPECT_EQ(result, elements);
+
+    auto reversed = std::vector<size_t>();
+    if (!elements.empty()) {
+      auto it = patchable_vec.rbegin();
+      for (auto i = 0UZ; i < elements.size(); ++i) {
+        reversed.push_back(*it);
+        if (i + 1UZ < elements.size()) --it;
+      }
+    }
+    std::ranges::reverse(reversed);
+    EXPECT_EQ(reversed, elements);
+
+    if (!elements.empty()) {
+      auto prev_it = patchable_vec.begin();
+      for (auto it = ++patchable_vec.begin(); it != patchable_vec.end(); ++it) {
+        auto copy = it;
+        --copy;
+        EXPECT_EQ(prev_it, copy);
+        prev_it = it;
+      }
+    }
+
+    for (auto i = 0UZ; i < elements.size(); ++i) {
+      EXPECT_EQ(patchable_vec[i], elements[i]);
+    }
+
+    auto concatenated = std::vector<size_t>();
+    patchable_vec.for_each_segment([&](std::span<const size_t> segment) {
+      concatenated.insert(concatenated.end(), segment.begin(), segment.end());
+    });
+    EXPECT_EQ(concatenated, elements);
+
+    auto merged = patchable_vec;
+    merged.merge_patches();
+    auto view = merged.view();
+    EXPECT_EQ(std::vector<size_t>(view.begin(), view.end()), elements);
+
+    auto squashed = patchable_vec;
+    squashed.squash();
+    EXPECT_EQ(squashed.base(), elements);
+  }
+}
+
+TEST(PatchableVector, Fork) {
+  auto rd = std::random_device();
+  auto gen = std::mt19937(rd());
+
+  auto dist = std::uniform_int_distribution(1UZ, 100UZ);
+
+  for (auto iter = 0UZ; iter < 100UZ; ++iter) {
+    auto elements = std::vector<size_t>();
+    auto element_cnt = dist(gen);
+    for (auto i = 0UZ; i < element_cnt; ++i) elements.push_back(i);
+
+    auto patchable_vec = cye::PatchableVector<size_t>(std::move(elements));
+    for (auto p = 0UZ; p < 2UZ; ++p) {
+      auto insertion_dist = std::uniform_int_distribution(0UZ, patchable_vec.size());
+      auto changes = std::vector<std::pair<size_t, size_t>>();
+      auto change_cnt = dist(gen) % 10UZ;
+      for (auto i = 0UZ; i < change_cnt; ++i) {
+        changes.emplace_back(insertion_dist(gen), 100UZ + dist(gen));
+      }
+      std::ranges::sort(changes);
+
+      auto patch = cye::Patch<size_t>();
+      for (auto [ind, value] : changes) {
+        patch.add_change(ind, value);
+      }
+      patchable_vec.add_patch(std::move(patch));
+    }
+
+    auto snapshot = patchable_vec.snapshot();
+    EXPECT_TRUE(snapshot->shares_base_with(patchable_vec));
+
+    auto forks = std::vector<cye::PatchableVector<size_t>::Fork>();
+    for (auto f = 0UZ; f < 4UZ; ++f) {
+      auto insertion_dist = std::uniform_int_distribution(0UZ, snapshot->size());
+      auto changes = std::vector<std::pair<size_t, size_t>>();
+      auto change_cnt = dist(gen) % 10UZ;
+      for (auto i = 0UZ; i < change_cnt; ++i) {
+        changes.emplace_back(insertion_dist(gen), 200UZ + dist(gen));
+      }
+      std::ranges::sort(changes);
+
+      auto patch = cye::Patch<size_t>();
+      for (auto [ind, value] : changes) {
+        patch.add_change(ind, value);
+      }
+      forks.emplace_back(snapshot, std::move(patch));
+    }
+
+    // Every fork is read from its own thread while the others read the same snapshot
+    auto segmented = std::vector<std::vector<size_t>>(forks.size());
+    auto indexed = std::vector<std::vector<size_t>>(forks.size());
+    auto threads = std::vector<std::thread>();
+    for (auto f = 0UZ; f < forks.size(); ++f) {
+      threads.emplace_back([&, f] {
+        forks[f].for_each_segment([&](std::span<const size_t> segment) {
+          segmented[f].insert(segmented[f].end(), segment.begin(), segment.end());
+        });
+        for (auto i = 0UZ; i < forks[f].size(); ++i) {
+          indexed[f].push_back(forks[f][i]);
+        }
+      });
+    }
+    for (auto &thread : threads) thread.join();
+
+    for (auto f = 0UZ; f < forks.size(); ++f) {
+      auto expected = patchable_vec;
+      auto top = forks[f].top_patch();
+      expected.add_patch(std::move(top));
+      expected.squash();
+
+      EXPECT_EQ(segmented[f], expected.base());
+      EXPECT_EQ(indexed[f], expected.base());
+
+      auto committed = std::move(forks[f]).commit();
+      EXPECT_TRUE(committed.shares_base_with(patchable_vec));
+      auto view = committed.view();
+      EXPECT_EQ(std::vector<size_t>(view.begin(), view.end()), expected.base());
+    }
+  }
+}
@@ -5,6 +5,7 @@
 #include <limits>
 #include <print>
 #include <random>
+#include <thread>
 #include <utility>
 #include <vector>
 #include "cye/init_heuristics.hpp"
@@ -77,7 +78,7 @@ TEST(Repair, LinearSplit) {
 
       auto solution_opt = cye::Solution(instance, std::move(copy));
       auto solution_ls = cye::Solution(instance, std::move(copy2));
-      cye::patch_cargo_optimally(solution_opt, static_cast<unsigned>(instance->cargo_capacity()) + 1u);
+      cye::patch_cargo_optimally(solution_opt, instance->cargo_bin_cnt());
       cye::linear_split(solution_ls);
 
       EXPECT_TRUE(solution_opt.is_cargo_valid());
@@ -88,6 +89,86 @@ TEST(Repair, LinearSplit) {
   }
 }
 
+TEST(Repair, LinearSplitBatch) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  auto workspaces = std::vector<cye::SplitWorkspace>(4);
+
+  for (const auto &path : std::filesystem::directory_iterator("dataset/json")) {
+    auto archive = serial::JSONArchive(path);
+    auto instance = std::make_shared<cye::Instance>(archive.root());
+
+    auto routes = std::vector<size_t>();
+    for (auto c : instance->customer_ids()) {
+      routes.push_back(c);
+    }
+
+    auto solutions = std::vector<cye::Solution>();
+    auto expected_costs = std::vector<double>();
+    for (auto i = 0UZ; i < 25UZ; i++) {
+      std::shuffle(routes.begin(), routes.end(), gen);
+
+      auto copy = routes;
+      auto solution = cye::Solution(instance, std::move(copy));
+      solutions.push_back(solution);
+      cye::linear_split(solution);
+      expected_costs.push_back(solution.cost());
+    }
+
+    cye::linear_split(solutions, workspaces);
+    for (auto i = 0UZ; i < solutions.size(); i++) {
+      EXPECT_TRUE(solutions[i].is_cargo_valid());
+      EXPECT_EQ(solutions[i].cost(), expected_costs[i]);
+    }
+  }
+}
+
+TEST(Repair, FleetSplit) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  auto workspace = cye::SplitWorkspace();
+
+  for (const auto &path : std::filesystem::directory_iterator("dataset/json")) {
+    auto archive = serial::JSONArchive(path);
+    auto instance = std::make_shared<cye::Instance>(archive.root());
+
+    auto routes = std::vector<size_t>();
+    for (auto c : instance->customer_ids()) {
+      routes.push_back(c);
+    }
+
+    for (auto i = 0UZ; i < 20UZ; i++) {
+      std::shuffle(routes.begin(), routes.end(), gen);
+
+      auto copy = routes;
+      auto copy2 = routes;
+      auto copy3 = routes;
+
+      auto solution_ls = cye::Solution(instance, std::move(copy));
+      auto solution_unlimited = cye::Solution(instance, std::move(copy2));
+      auto solution_limited = cye::Solution(instance, std::move(copy3));
+      cye::linear_split(solution_ls);
+
+      // With one vehicle per customer the fleet never binds
+      ASSERT_TRUE(cye::fleet_split(solution_unlimited, instance->customer_cnt(), workspace));
+      EXPECT_TRUE(solution_unlimited.is_cargo_valid());
+      EXPECT_NEAR(solution_unlimited.cost(), solution_ls.cost(), 1e-3);
+
+      auto max_route_cnt = solution_unlimited.get_patch(0).size() - 1;
+      if (max_route_cnt > instance->minimum_route_cnt()) {
+        --max_route_cnt;
+      }
+      if (cye::fleet_split(solution_limited, max_route_cnt, workspace)) {
+        EXPECT_TRUE(solution_limited.is_cargo_valid());
+        EXPECT_LE(solution_limited.get_patch(0).size() - 1, max_route_cnt);
+        EXPECT_GE(solution_limited.cost() - solution_unlimited.cost(), -1e-3);
+      } else {
+        EXPECT_EQ(solution_limited.routes().size(), instance->customer_cnt());
+      }
+    }
+  }
+}
+
 TEST(Repair, PatchCargoOptimally) {
   std::random_device rd;
   std::mt19937 gen(rd());
@@ -111,7 +192,7 @@ TEST(Repair, PatchCargoOptimally) {
 
       auto solution_opt = cye::Solution(instance, std::move(copy));
       auto solution_tr = cye::Solution(instance, std::move(copy2));
-      cye::patch_cargo_optimally(solution_opt, static_cast<unsigned>(instance->cargo_capacity()) + 1u);
+      cye::patch_cargo_optimally(solution_opt, instance->cargo_bin_cnt());
       cye::patch_cargo_trivially(solution_tr);
 
       EXPECT_TRUE(solution_opt.is_cargo_valid());
@@ -122,6 +203,148 @@ TEST(Repair, PatchCargoOptimally) {
   }
 }
 
+TEST(Repair, PatchCargoOptimallyLabels) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  auto workspace = cye::CargoLabelWorkspace();
+
+  for (const auto &path : std::filesystem::directory_iterator("dataset/json")) {
+    auto archive = serial::JSONArchive(path);
+    auto instance = std::make_shared<cye::Instance>(archive.root());
+
+    auto routes = std::vector<size_t>();
+    for (auto c : instance->customer_ids()) {
+      routes.push_back(c);
+    }
+
+    for (auto i = 0UZ; i < 20UZ; i++) {
+      std::shuffle(routes.begin(), routes.end(), gen);
+
+      auto copy = routes;
+      auto copy2 = routes;
+
+      auto solution_bins = cye::Solution(instance, std::move(copy));
+      auto solution_labels = cye::Solution(instance, std::move(copy2));
+      cye::patch_cargo_optimally(solution_bins, instance->cargo_bin_cnt());
+      cye::patch_cargo_optimally(solution_labels, workspace);
+
+      EXPECT_TRUE(solution_labels.is_cargo_valid());
+      EXPECT_NEAR(solution_labels.cost(), solution_bins.cost(), 1e-3);
+      EXPECT_TRUE(std::ranges::equal(solution_labels.routes().view(), solution_bins.routes().view()));
+      // Ties next to the depot go straight, so no depot follows another
+      auto depots = [&](size_t a, size_t b) { return a == instance->depot_id() && b == instance->depot_id(); };
+      EXPECT_EQ(std::ranges::adjacent_find(solution_labels.routes().view(), depots),
+                solution_labels.routes().view().end());
+    }
+  }
+}
+
+TEST(Repair, PatchCargoOptimallyLabelsGrowingWorkspace) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  // A workspace sized by a small instance, and then an empty one, have to grow their label buffer while a front is
+  // still being built from the previous one
+  auto small_archive = serial::JSONArchive("dataset/json/E-n22-k4.json");
+  auto small_instance = std::make_shared<cye::Instance>(small_archive.root());
+  auto small_routes = std::vector<size_t>();
+  for (auto c : small_instance->customer_ids()) {
+    small_routes.push_back(c);
+  }
+
+  auto archive = serial::JSONArchive("dataset/json/X-n916-k207.json");
+  auto instance = std::make_shared<cye::Instance>(archive.root());
+  auto routes = std::vector<size_t>();
+  for (auto c : instance->customer_ids()) {
+    routes.push_back(c);
+  }
+
+  for (auto i = 0UZ; i < 5UZ; i++) {
+    std::shuffle(routes.begin(), routes.end(), gen);
+
+    auto used_workspace = cye::CargoLabelWorkspace();
+    auto small_solution = cye::Solution(small_instance, std::vector(small_routes));
+    cye::patch_cargo_optimally(small_solution, used_workspace);
+
+    auto empty_workspace = cye::CargoLabelWorkspace();
+    auto solution_bins = cye::Solution(instance, std::vector(routes));
+    auto solution_used = solution_bins;
+    auto solution_empty = solution_bins;
+    cye::patch_cargo_optimally(solution_bins, instance->cargo_bin_cnt());
+    cye::patch_cargo_optimally(solution_used, used_workspace);
+    cye::patch_cargo_optimally(solution_empty, empty_workspace);
+
+    EXPECT_TRUE(solution_used.is_cargo_valid());
+    EXPECT_TRUE(solution_empty.is_cargo_valid());
+    EXPECT_NEAR(solution_used.cost(), solution_bins.cost(), 1e-3);
+    EXPECT_NEAR(solution_empty.cost(), solution_bins.cost(), 1e-3);
+    EXPECT_TRUE(std::ranges::equal(solution_used.routes().view(), solution_bins.routes().view()));
+    EXPECT_TRUE(std::ranges::equal(solution_empty.routes().view(), solution_bins.routes().view()));
+  }
+}
+
+TEST(Repair, PatchCargoKeepsBaseShared) {
+  auto archive = serial::JSONArchive("dataset/json/E-n33-k4.json");
+  auto instance = std::make_shared<cye::Instance>(archive.root());
+
+  auto routes = std::vector<size_t>();
+  for (auto c : instance->customer_ids()) {
+    routes.push_back(c);
+  }
+  auto parent = cye::Solution(instance, std::move(routes));
+
+  // The repairs only add patches, so a freshly copied child keeps sharing the genotype of its parent
+  auto child_bins = parent;
+  auto child_labels = parent;
+  cye::patch_cargo_optimally(child_bins, instance->cargo_bin_cnt());
+  cye::patch_cargo_optimally(child_labels);
+
+  EXPECT_TRUE(child_bins.routes().shares_base_with(parent.routes()));
+  EXPECT_TRUE(child_labels.routes().shares_base_with(parent.routes()));
+  EXPECT_TRUE(child_bins.is_cargo_valid());
+  EXPECT_NEAR(child_bins.cost(), child_labels.cost(), 1e-3);
+}
+
+TEST(Repair, PatchCargoOptimallyIncremental) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  auto workspace = cye::CargoLabelWorkspace();
+  auto incremental_workspace = cye::CargoLabelWorkspace();
+
+  for (const auto &path : std::filesystem::directory_iterator("dataset/json")) {
+    auto archive = serial::JSONArchive(path);
+    auto instance = std::make_shared<cye::Instance>(archive.root());
+
+    auto routes = std::vector<size_t>();
+    for (auto c : instance->customer_ids()) {
+      routes.push_back(c);
+    }
+    std::shuffle(routes.begin(), routes.end(), gen);
+
+    auto copy = routes;
+    auto solution = cye::Solution(instance, std::move(copy));
+    cye::patch_cargo_optimally(solution, incremental_workspace);
+
+    auto dist = std::uniform_int_distribution(0UZ, routes.size() - 1);
+    for (auto i = 0UZ; i < 50UZ; i++) {
+      auto a = dist(gen);
+      auto b = dist(gen);
+      std::swap(routes[a], routes[b]);
+
+      auto copy = routes;
+      auto solution_full = cye::Solution(instance, std::move(copy));
+      cye::patch_cargo_optimally(solution_full, workspace);
+
+      solution.clear_patches();
+      std::swap(solution.base()[a], solution.base()[b]);
+      cye::patch_cargo_optimally(solution, incremental_workspace, std::min(a, b), std::max(a, b));
+
+      EXPECT_TRUE(solution.is_cargo_valid());
+      EXPECT_NEAR(solution.cost(), solution_full.cost(), 1e-6);
+    }
+  }
+}
+
 TEST(Repair, PatchEnergyTrivially) {
   std::random_device rd;
   std::mt19937 gen(rd());
@@ -186,6 +409,221 @@ TEST(Repair, PatchEnergyOptimally) {
   }
 }
 
+TEST(Repair, PatchEnergyOptimallyLabels) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  for (const auto &path : std::filesystem::directory_iterator("dataset/json")) {
+    auto archive = serial::JSONArchive(path);
+    auto instance = std::make_shared<cye::Instance>(archive.root());
+    auto optimal_energy_repair = cye::OptimalEnergyRepair(instance);
+
+    auto routes = std::vector<size_t>();
+    for (auto c : instance->customer_ids()) {
+      routes.push_back(c);
+    }
+
+    for (auto i = 0UZ; i < 10UZ; i++) {
+      std::shuffle(routes.begin(), routes.end(), gen);
+
+      auto copy = routes;
+      auto solution_labels = cye::Solution(instance, std::move(copy));
+      cye::patch_cargo_optimally(solution_labels);
+      auto solution_bins = solution_labels;
+
+      optimal_energy_repair.patch(solution_bins, 101u);
+      optimal_energy_repair.patch(solution_labels);
+
+      // The bins round the battery down, so they can only miss detours the labels find
+      EXPECT_TRUE(solution_labels.is_valid());
+      EXPECT_LE(solution_labels.cost(), solution_bins.cost() + 1e-6);
+    }
+  }
+}
+
+TEST(Repair, PatchEnergyRoutes) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  for (const auto &path : std::filesystem::directory_iterator("dataset/json")) {
+    auto archive = serial::JSONArchive(path);
+    auto instance = std::make_shared<cye::Instance>(archive.root());
+    auto optimal_energy_repair = cye::OptimalEnergyRepair(instance);
+
+    auto routes = std::vector<size_t>();
+    for (auto c : instance->customer_ids()) {
+      routes.push_back(c);
+    }
+    std::shuffle(routes.begin(), routes.end(), gen);
+
+    for (auto i = 0UZ; i < 10UZ; i++) {
+      // Swapping two neighbours changes at most two routes, the others come from the cache
+      auto swap_ind = std::uniform_int_distribution<size_t>(0, routes.size() - 2)(gen);
+      std::swap(routes[swap_ind], routes[swap_ind + 1]);
+
+      auto copy = routes;
+      auto solution_routes = cye::Solution(instance, std::move(copy));
+      cye::patch_cargo_optimally(solution_routes);
+      auto solution_whole = solution_routes;
+
+      optimal_energy_repair.patch(solution_whole);
+      optimal_energy_repair.patch_routes(solution_routes);
+
+      EXPECT_TRUE(solution_routes.is_valid());
+      EXPECT_NEAR(solution_routes.cost(), solution_whole.cost(), 1e-6);
+    }
+  }
+}
+
+TEST(Repair, PatchEnergyRoutesSharedCache) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  // Two instances with the same node ids share one cache, a route of one must not come back for the other
+  auto route_cache = std::make_shared<cye::RouteCache>();
+  auto instances = std::vector<std::shared_ptr<cye::Instance>>();
+  for (auto name : {"dataset/json/E-n22-k4.json", "dataset/json/E-n23-k3.json"}) {
+    auto archive = serial::JSONArchive(name);
+    instances.push_back(std::make_shared<cye::Instance>(archive.root()));
+  }
+
+  auto routes = std::vector<size_t>();
+  for (auto c : instances[0]->customer_ids()) {
+    if (std::ranges::find(instances[1]->customer_ids(), c) != instances[1]->customer_ids().end()) {
+      routes.push_back(c);
+    }
+  }
+
+  for (auto i = 0UZ; i < 10UZ; i++) {
+    std::shuffle(routes.begin(), routes.end(), gen);
+    for (auto &instance : instances) {
+      auto shared_repair = cye::OptimalEnergyRepair(instance, route_cache);
+      auto own_repair = cye::OptimalEnergyRepair(instance);
+
+      auto solution_shared = cye::Solution(instance, std::vector(routes));
+      cye::patch_cargo_optimally(solution_shared);
+      auto solution_own = solution_shared;
+
+      shared_repair.patch_routes(solution_shared);
+      own_repair.patch_routes(solution_own);
+
+      // Only the customers of both instances are visited, so the solutions are not complete
+      EXPECT_TRUE(solution_shared.is_energy_and_cargo_valid());
+      EXPECT_NEAR(solution_shared.cost(), solution_own.cost(), 1e-6);
+    }
+  }
+}
+
+TEST(Repair, PatchEnergyConcurrently) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  auto archive = serial::JSONArchive("dataset/json/X-n143-k7.json");
+  auto instance = std::make_shared<cye::Instance>(archive.root());
+  auto optimal_energy_repair = cye::OptimalEnergyRepair(instance);
+
+  auto routes = std::vector<size_t>();
+  for (auto c : instance->customer_ids()) {
+    routes.push_back(c);
+  }
+
+  auto solutions = std::vector<cye::Solution>();
+  auto expected_costs = std::vector<double>();
+  auto workspace = cye::EnergyRepairWorkspace();
+  for (auto i = 0UZ; i < 32UZ; i++) {
+    std::shuffle(routes.begin(), routes.end(), gen);
+    auto copy = routes;
+    auto &solution = solutions.emplace_back(instance, std::move(copy));
+    cye::patch_cargo_optimally(solution);
+
+    auto expected = solution;
+    optimal_energy_repair.patch(expected, workspace);
+    expected_costs.push_back(expected.cost());
+  }
+
+  // One repair, one thread per solution, every thread on its own thread-local workspace
+  {
+    auto threads = std::vector<std::jthread>();
+    for (auto &solution : solutions) {
+      threads.emplace_back([&] { optimal_energy_repair.patch_routes(solution); });
+    }
+  }
+
+  for (auto i = 0UZ; i < solutions.size(); i++) {
+    EXPECT_TRUE(solutions[i].is_valid());
+    EXPECT_NEAR(solutions[i].cost(), expected_costs[i], 1e-6);
+  }
+}
+
+TEST(Repair, PatchEnergyOptimallyPruned) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  for (const auto &path : std::filesystem::directory_iterator("dataset/json")) {
+    auto archive = serial::JSONArchive(path);
+    auto instance = std::make_shared<cye::Instance>(archive.root());
+    auto optimal_energy_repair = cye::OptimalEnergyRepair(instance);
+
+    auto routes = std::vector<size_t>();
+    for (auto c : instance->customer_ids()) {
+      routes.push_back(c);
+    }
+
+    for (auto i = 0UZ; i < 5UZ; i++) {
+      std::shuffle(routes.begin(), routes.end(), gen);
+
+      auto copy = routes;
+      auto solution = cye::Solution(instance, std::move(copy));
+      cye::patch_cargo_optimally(solution);
+
+      // The full table keeps every bin, its cheapest bin in the last column is the optimum the pruned one must find
+      auto bin_cnt = 101u;
+      auto dp = optimal_energy_repair.fill_dp(solution, bin_cnt);
+      auto optimum = std::numeric_limits<double>::infinity();
+      for (auto const &row : dp) {
+        optimum = std::min(optimum, row.back().dist);
+      }
+
+      optimal_energy_repair.patch(solution, bin_cnt);
+      EXPECT_TRUE(solution.is_valid());
+      EXPECT_NEAR(solution.cost(), optimum, 1e-6);
+    }
+  }
+}
+
+TEST(Repair, PatchEnergyOptimallyCheckpointed) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  for (const auto &path : std::filesystem::directory_iterator("dataset/json")) {
+    auto archive = serial::JSONArchive(path);
+    auto instance = std::make_shared<cye::Instance>(archive.root());
+    auto optimal_energy_repair = cye::OptimalEnergyRepair(instance);
+
+    auto routes = std::vector<size_t>();
+    for (auto c : instance->customer_ids()) {
+      routes.push_back(c);
+    }
+
+    for (auto i = 0UZ; i < 3UZ; i++) {
+      std::shuffle(routes.begin(), routes.end(), gen);
+
+      auto copy = routes;
+      auto solution_full = cye::Solution(instance, std::move(copy));
+      cye::patch_cargo_optimally(solution_full);
+      auto solution_checkpointed = solution_full;
+
+      // A budget this small forces checkpoints only a few columns apart
+      auto bin_cnt = 51u;
+      optimal_energy_repair.patch(solution_full, bin_cnt);
+      optimal_energy_repair.patch(solution_checkpointed, bin_cnt, 16UZ * bin_cnt * sizeof(cye::DPCell));
+
+      EXPECT_TRUE(solution_checkpointed.is_valid());
+      EXPECT_NEAR(solution_checkpointed.cost(), solution_full.cost(), 1e-6);
+    }
+  }
+}
+
 TEST(Repair, DPSparsity) {
   auto archive = serial::JSONArchive("dataset/json/X-n916-k207.json");
   auto instance = std::make_shared<cye::Instance>(archive.root());
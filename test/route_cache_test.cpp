@@ -0,0 +1,111 @@
+#include "cye/route_cache.hpp"
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+TEST(RouteCache, FindInserted) {
+  auto cache = cye::RouteCache();
+  auto route = std::vector<size_t>{0, 3, 5, 0};
+  auto hash = cye::RouteCache::hash(0, route);
+  auto detours = std::vector<cye::ChargingDetour>();
+  auto cost = 0.0;
+
+  EXPECT_FALSE(cache.find(0, hash, route, detours, cost));
+  cache.insert(0, hash, route, std::vector{cye::ChargingDetour{2, 1, 1}}, 42.0);
+  EXPECT_TRUE(cache.find(0, hash, route, detours, cost));
+  ASSERT_EQ(detours.size(), 1UZ);
+  EXPECT_EQ(detours[0].position, 2UZ);
+  EXPECT_EQ(cost, 42.0);
+
+  // A colliding hash with other nodes is a miss
+  auto other_route = std::vector<size_t>{0, 5, 3, 0};
+  EXPECT_FALSE(cache.find(0, hash, other_route, detours, cost));
+  EXPECT_EQ(cache.hit_cnt(), 1UZ);
+  EXPECT_EQ(cache.miss_cnt(), 2UZ);
+}
+
+TEST(RouteCache, KeyedByNetwork) {
+  auto cache = cye::RouteCache();
+  auto route = std::vector<size_t>{0, 3, 5, 0};
+  auto detours = std::vector<cye::ChargingDetour>();
+  auto cost = 0.0;
+
+  // The same nodes repaired on another network are a different route
+  cache.insert(0, cye::RouteCache::hash(0, route), route, std::vector{cye::ChargingDetour{2, 1, 1}}, 42.0);
+  EXPECT_FALSE(cache.find(1, cye::RouteCache::hash(1, route), route, detours, cost));
+  EXPECT_FALSE(cache.find(1, cye::RouteCache::hash(0, route), route, detours, cost));
+
+  cache.insert(1, cye::RouteCache::hash(1, route), route, {}, 21.0);
+  EXPECT_TRUE(cache.find(0, cye::RouteCache::hash(0, route), route, detours, cost));
+  EXPECT_EQ(cost, 42.0);
+  EXPECT_EQ(detours.size(), 1UZ);
+  EXPECT_TRUE(cache.find(1, cye::RouteCache::hash(1, route), route, detours, cost));
+  EXPECT_EQ(cost, 21.0);
+  EXPECT_TRUE(detours.empty());
+}
+
+TEST(RouteCache, KeepsInsertedRoute) {
+  auto detours = std::vector<cye::ChargingDetour>();
+  auto cost = 0.0;
+
+  // Inserting a cached route again with many detours grows its slot in place, the sweep that evicts the others to
+  // make room must not reach it wherever it sits
+  auto long_detours = std::vector<cye::ChargingDetour>(200UZ, cye::ChargingDetour{1, 0, 0});
+  for (auto kept = 0UZ; kept < 20UZ; ++kept) {
+    auto cache = cye::RouteCache(1UZ << 12, 1);
+    for (auto i = 0UZ; i < 20UZ; ++i) {
+      auto route = std::vector<size_t>{0, i, i + 1, 0};
+      cache.insert(0, cye::RouteCache::hash(0, route), route, {}, 1.0);
+    }
+
+    auto route = std::vector<size_t>{0, kept, kept + 1, 0};
+    auto hash = cye::RouteCache::hash(0, route);
+    cache.insert(0, hash, route, long_detours, 2.0);
+    EXPECT_TRUE(cache.find(0, hash, route, detours, cost));
+    EXPECT_EQ(detours.size(), long_detours.size());
+    EXPECT_EQ(cost, 2.0);
+  }
+}
+
+TEST(RouteCache, StaysWithinBudget) {
+  auto memory_budget = 1UZ << 14;
+  auto cache = cye::RouteCache(memory_budget, 4);
+
+  for (auto i = 0UZ; i < 10'000UZ; ++i) {
+    auto route = std::vector<size_t>{0, i, i + 1, 0};
+    cache.insert(0, cye::RouteCache::hash(0, route), route, {}, 1.0);
+  }
+
+  EXPECT_LE(cache.memory_usage(), memory_budget);
+  EXPECT_GT(cache.route_cnt(), 0UZ);
+  EXPECT_LT(cache.route_cnt(), 10'000UZ);
+}
+
+TEST(RouteCache, ConcurrentAccess) {
+  // Room for all 500 routes, a cyclic walk over more routes than fit would miss every time
+  auto cache = cye::RouteCache(1UZ << 17, 8);
+
+  auto work = [&](size_t thread_ind) {
+    auto detours = std::vector<cye::ChargingDetour>();
+    auto cost = 0.0;
+    for (auto i = 0UZ; i < 20'000UZ; ++i) {
+      auto route = std::vector<size_t>{0, (i * 7 + thread_ind) % 500, 0};
+      auto hash = cye::RouteCache::hash(0, route);
+      if (cache.find(0, hash, route, detours, cost)) {
+        EXPECT_EQ(cost, static_cast<double>(route[1]));
+      } else {
+        cache.insert(0, hash, route, {}, static_cast<double>(route[1]));
+      }
+    }
+  };
+
+  auto threads = std::vector<std::jthread>();
+  for (auto t = 0UZ; t < 4UZ; ++t) {
+    threads.emplace_back(work, t);
+  }
+  threads.clear();
+
+  EXPECT_EQ(cache.hit_cnt() + cache.miss_cnt(), 80'000UZ);
+  EXPECT_GT(cache.hit_rate(), 0.5);
+}